@@ -2,6 +2,11 @@ require 'sinatra/base'
 require 'open3'
 require 'json'
 
+# Compiles are handed to a resident 'conec --server=/tmp/conec.sock' when one is
+# running, which spares each request conec's start-up. With none, conec-client
+# runs conec itself.
+CONEC = "conec-client --client=/tmp/conec.sock"
+
 class PlayCone < Sinatra::Base
   get "/" do
 	send_file File.expand_path('index.html', settings.public_folder)
@@ -15,7 +20,7 @@ class PlayCone < Sinatra::Base
 	
 	# Run compile and generate hash object with requested file or error message
 	prog_out = ""
-	rc, stdout, conec_err = docmd("conec -owork/ work/test.cone")
+	rc, stdout, conec_err = docmd("#{CONEC} -owork/ work/test.cone")
 	if rc == 0
 		# linkedit with the cone standard library. Path is needed for success
 		ENV['PATH'] = "/usr/local/sbin:/usr/local/bin:/usr/sbin:/usr/bin:/sbin:/bin"
@@ -44,7 +49,7 @@ class PlayCone < Sinatra::Base
 	File.open("work/test.cone", 'w') { |file| file.write(body['code']) }
 	
 	# Run compile and generate hash object with requested file or error message
-	rc, stdout, error = docmd("conec --asm --llvmir -owork/ work/test.cone")
+	rc, stdout, error = docmd("#{CONEC} --asm --llvmir -owork/ work/test.cone")
 	if rc == 0
 		# retrieve results on success
 		resultfile = body['emit'] == 'asm' ? "work/test.s" : "work/test.ir"
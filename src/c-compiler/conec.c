@@ -7,7 +7,10 @@
 
 #include "conec.h"
 #include "coneopts.h"
+#include "conesrv.h"
+#include "conecache.h"
 #include "shared/fileio.h"
+#include "shared/memory.h"
 #include "ir/nametbl.h"
 #include "ir/ir.h"
 #include "shared/error.h"
@@ -17,8 +20,28 @@
 #include "genllvm/genllvm.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
+// Count the declarations of imported modules that nothing reached, so that
+// neither type check nor generation did anything with them
+static void doCountUnreached(ProgramNode *pgm, uint32_t *unreached, uint32_t *total) {
+    *unreached = *total = 0;
+    INode **modsp;
+    uint32_t modcnt;
+    for (nodesFor(pgm->modules, modcnt, modsp)) {
+        if ((*modsp)->flags & FlagGenMod)
+            continue;
+        INode **nodesp;
+        uint32_t cnt;
+        for (nodesFor(((ModuleNode*)*modsp)->nodes, cnt, nodesp)) {
+            ++*total;
+            if (!inodeIsReached(*nodesp))
+                ++*unreached;
+        }
+    }
+}
+
 // Run all semantic analysis passes against the AST/IR (after parse and before gen)
 void doAnalysis(ConeOptions *opt, ProgramNode **pgm) {
 
@@ -48,9 +71,10 @@ void doAnalysis(ConeOptions *opt, ProgramNode **pgm) {
     // Where the first walk is eager and in source order, this one is
     // demand-driven. Reaching a name analyzes the declaration it names before
     // carrying on, so declarations are analyzed in dependency order and each is
-    // analyzed once, however many places reach it. A module iterates its
-    // declarations to be sure every one is reached; it does not decide the
-    // order. See design/phases/type-check.md.
+    // analyzed once, however many places reach it. A generated module iterates
+    // its declarations to be sure every one is reached; it does not decide the
+    // order. An imported one is not iterated, so what no generated module reaches
+    // is neither analyzed nor generated. See design/phases/type-check.md.
     //
     // Along the way:
     // - Macros and generic instantiations are substituted, and the instance is
@@ -73,46 +97,227 @@ void doAnalysis(ConeOptions *opt, ProgramNode **pgm) {
     tstate.scope = 0;
     inodeTypeCheckAny(&tstate, (INode**)pgm);
 
+    if (opt->print_stats) {
+        uint32_t unreached, total;
+        doCountUnreached(*pgm, &unreached, &total);
+        printf("Imported declarations never reached: %u of %u\n", unreached, total);
+        genericPrintStats();
+        typetblPrintStats();
+    }
+
     if (opt->check_tree)
         inodeCheckTree((INode*)*pgm);
 }
 
+// Compile the source file coneopt names into a program whose core library
+// parsePgmStart has already parsed
+void doCompile(ConeOptions *coneopt, GenState *gen, ProgramNode *pgmnode, int argc, char **argv) {
+    // An object the cache has for these sources is the whole compile.
+    // A compile that warns is not cached, so its warnings are never skipped.
+    char *cached = NULL;
+    timerBegin(LoadTimer);
+    if (cacheUsable(coneopt)) {
+        cached = genlObjPath(coneopt);
+        if (cacheFetch(coneopt, cached, argv[0]))
+            pgmnode = NULL;
+    }
+
+    // Parse source file, do semantic analysis, and generate code
+    if (pgmnode) {
+        timerBegin(ParseTimer);
+        if (timerTracing)
+            timerTraceBegin("Parse", coneopt->srcpath);
+        parsePgmMain(pgmnode, coneopt);
+        if (timerTracing)
+            timerTraceEnd();
+        if (errors == 0) {
+            timerBegin(SemTimer);
+            if (timerTracing)
+                timerTraceBegin("Analysis", NULL);
+            doAnalysis(coneopt, &pgmnode);
+            if (timerTracing)
+                timerTraceEnd();
+            if (errors == 0) {
+                timerBegin(GenTimer);
+                if (coneopt->print_ir)
+                    inodePrint(coneopt->output, coneopt->srcname, (INode*)pgmnode);
+                genpgm(gen, pgmnode);
+                genClose(gen);
+            }
+        }
+        timerBegin(LoadTimer);
+        if (cached && errors == 0 && warnings == 0)
+            cacheStore(coneopt, cached);
+    }
+    timerBegin(TimerCount);
+
+    // Close up everything necessary
+    timerTraceClose();
+    if (coneopt->print_stats)
+        memPrintStats(inodeTagName);
+    if (coneopt->verbosity > 0)
+        timerPrint();
+    errorSummary();
+
+    // With --run, the compile was into memory and the program runs now, here.
+    // Its arguments are those after its source, whose path is its argv[0].
+    if (coneopt->run)
+        exit(genlJitRun(gen, argc - 1, argv + 1));
+}
+
+// With --lto there is no source to compile: link the bitcode files named
+// after the options, and the runtime's beside conec for --runtimebc, into one
+// program, optimize it whole and write its object
+static void doLto(ConeOptions *coneopt, GenState *gen, char *conec, int argc, char **argv) {
+    if (coneopt->run)
+        errorExit(ExitOpts, "--run compiles a source, so it cannot be used with --lto");
+    char **paths = memAllocBlk(argc * sizeof(char*));
+    int npaths = 0;
+    for (int i = 1; i < argc; ++i)
+        paths[npaths++] = argv[i];
+    if (coneopt->runtimebc) {
+        size_t folder = fileFolder(conec);
+        paths[npaths++] = fileMakePath(memAllocStr(conec, folder), "conestd", "bc");
+    }
+
+    genlLto(gen, paths, npaths);
+    genClose(gen);
+    timerBegin(TimerCount);
+
+    timerTraceClose();
+    if (coneopt->print_stats)
+        memPrintStats(inodeTagName);
+    if (coneopt->verbosity > 0)
+        timerPrint();
+    errorSummary();
+}
+
+// What a compile server set up, for every request it serves
+static ConeOptions servedOpt;   // The server's options, before setup resolved them
+static GenState servedGen;
+static ProgramNode *servedPgm;
+static char *servedConec;       // Where the server's conec is, which --runtimebc looks beside
+
+// Whether an options' string is the same in both, unset included
+static int doSameOpt(char *a, char *b) {
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+// Compile a request, in the process a compile server forked for it (see conesrv.c).
+// It starts from the server's state, but only its own options apply.
+static int doServedCompile(int argc, char **argv) {
+    ConeOptions coneopt;
+    GenState gen;
+
+    timerReset();
+    int ok = coneOptSet(&coneopt, &argc, argv);
+    if (ok <= 0)
+        return ok == 0 ? 0 : ExitOpts;
+    if (argc < 2)
+        errorExit(ExitOpts, "Specify a Cone program to compile.");
+    coneopt.srcpath = argv[1];
+    coneopt.srcname = fileName(coneopt.srcpath);
+    if (coneopt.time_trace)
+        timerTraceOpen(coneopt.time_trace);
+
+    // Generation starts from the server's state. Options that would make the
+    // server's target machine use it, as the server resolved them. Others make
+    // their own, but the core library was parsed for the server's pointer size,
+    // and is no use to a target with another.
+    timerBegin(SetupTimer);
+    gen = servedGen;
+    gen.opt = &coneopt;
+    if (doSameOpt(coneopt.triple, servedOpt.triple) && doSameOpt(coneopt.cpu, servedOpt.cpu)
+        && doSameOpt(coneopt.features, servedOpt.features) && coneopt.opt_level == servedOpt.opt_level
+        && (coneopt.pic || coneopt.library) == (servedOpt.pic || servedOpt.library)
+        && coneopt.run == servedOpt.run) {
+        coneopt.triple = servedGen.opt->triple;
+        coneopt.cpu = servedGen.opt->cpu;
+        coneopt.features = servedGen.opt->features;
+        coneopt.pic = servedGen.opt->pic;
+        coneopt.ptrsize = servedGen.opt->ptrsize;
+    }
+    else {
+        genSetupTarget(&gen, &coneopt);
+        if (coneopt.ptrsize != servedGen.opt->ptrsize)
+            return -1;
+    }
+    if (coneopt.lto)
+        doLto(&coneopt, &gen, servedConec, argc, argv);
+    else
+        doCompile(&coneopt, &gen, servedPgm, argc, argv);
+    return 0;
+}
+
 int main(int argc, char **argv) {
     ConeOptions coneopt;
     GenState gen;
     int ok;
 
-    // Get compiler's options from passed arguments
+    // Arenas come out of one reserved address range, if chosen. That is decided
+    // before anything is allocated, so no malloc'd arena is left behind.
+    int arena = coneOptArenaFirst(argc, argv);
+    int reserved = arena > 0 && memArenaReserve(arena == 2);
+
+    // Get compiler's options from passed arguments.
+    // A client sends the command line on as it was given, options and all,
+    // and parsing them rewrites it.
+    int clientargc = argc;
+    char **clientargv = memAllocBlk((argc + 1) * sizeof(char*));
+    for (int i = 0; i < argc; ++i)
+        clientargv[i] = memAllocStr(argv[i], strlen(argv[i]));
+    clientargv[argc] = NULL;
     ok = coneOptSet(&coneopt, &argc, argv);
     if (ok <= 0)
         exit(ok == 0 ? 0 : ExitOpts);
+
+    if (coneopt.arena && !reserved && coneopt.verbosity > 0)
+        printf("Could not reserve an arena; arenas will be malloc'd\n");
+
+    if (coneopt.client) {
+        int status = coneClient(coneopt.client, clientargc, clientargv);
+        if (status >= 0)
+            exit(status);
+    }
+
+    // A server does the setup every compile shares, then serves requests until killed
+    if (coneopt.server) {
+        servedOpt = coneopt;
+        timerBegin(SetupTimer);
+        genSetup(&gen, &coneopt);
+        timerBegin(ParseTimer);
+        servedGen = gen;
+        servedPgm = parsePgmStart(&coneopt);
+        servedConec = argv[0];
+        timerBegin(TimerCount);
+        coneServe(coneopt.server, argv[0], doServedCompile);
+    }
+
     if (argc < 2)
         errorExit(ExitOpts, "Specify a Cone program to compile.");
     coneopt.srcpath = argv[1];
     coneopt.srcname = fileName(coneopt.srcpath);
+    if (coneopt.time_trace)
+        timerTraceOpen(coneopt.time_trace);
 
     // We set up generation early because we need target info, e.g.: pointer size
     timerBegin(SetupTimer);
+    if (timerTracing)
+        timerTraceBegin("Setup", NULL);
     genSetup(&gen, &coneopt);
+    if (timerTracing)
+        timerTraceEnd();
 
-    // Parse source file, do semantic analysis, and generate code
-    timerBegin(ParseTimer);
-    ProgramNode* pgmnode = parsePgm(&coneopt);
-    if (errors == 0) {
-        timerBegin(SemTimer);
-        doAnalysis(&coneopt, &pgmnode);
-        if (errors == 0) {
-            timerBegin(GenTimer);
-            if (coneopt.print_ir)
-                inodePrint(coneopt.output, coneopt.srcname, (INode*)pgmnode);
-            genpgm(&gen, pgmnode);
-            genClose(&gen);
-        }
+    if (coneopt.lto) {
+        doLto(&coneopt, &gen, argv[0], argc, argv);
+        return 0;
     }
-    timerBegin(TimerCount);
 
-    // Close up everything necessary
-    if (coneopt.verbosity > 0)
-        timerPrint();
-    errorSummary();
+    timerBegin(ParseTimer);
+    if (timerTracing)
+        timerTraceBegin("ParseCoreLibrary", NULL);
+    ProgramNode *pgmnode = parsePgmStart(&coneopt);
+    if (timerTracing)
+        timerTraceEnd();
+    doCompile(&coneopt, &gen, pgmnode, argc, argv);
 }
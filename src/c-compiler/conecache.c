@@ -0,0 +1,350 @@
+/** Object cache, for --cache-dir
+ * @file
+ *
+ * A compile whose source, imports and options are all what they were last time
+ * produces the same object file, so the cache keeps that object and skips the
+ * compile: no parse, no analysis and no LLVM.
+ *
+ * What a compile's imports are is only known by parsing it, so a cache entry is
+ * two files, both named by hashes:
+ * - The dependency list, named by a hash of the options and the compiler. It
+ *   lists every path the compile looked for a source file at, in order,
+ *   marked with whether one was there. A path where nothing was found is listed
+ *   because putting a file there would change which one an import finds.
+ * - The object, named by a hash of the same, then each listed path and the
+ *   contents of the file there now. Any edit to any of them is another name.
+ * A lookup reads the list and hashes the files it names. If an import was added
+ * or removed, the source that did so has changed, and so has the name.
+ *
+ * The compiler is part of the key by a hash of its executable, since a rebuilt
+ * compiler may generate other code for the same source. Hashing it takes a
+ * while, so the cache keeps the hash in a file named by the executable's path,
+ * size and modification time. Where the executable cannot be found, the cache
+ * is not used.
+ *
+ * Objects are copied in and out rather than hard-linked, so that a tool that
+ * rewrites an object in place cannot rewrite the cache's copy too.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "conec.h"
+#include "conecache.h"
+#include "shared/fileio.h"
+#include "shared/memory.h"
+
+#include <llvm/Config/llvm-config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(dir, mode) _mkdir(dir)
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+// A 128-bit FNV-1a hash, kept in two 64-bit halves so that it needs no 128-bit
+// integer type. The FNV prime at this size is 2^88 + 0x13B.
+typedef struct {
+    uint64_t hi;
+    uint64_t lo;
+} CacheHash;
+
+static void cacheHashInit(CacheHash *hash) {
+    hash->hi = 0x6c62272e07bb0142ull;
+    hash->lo = 0x62b821756295c58dull;
+}
+
+static void cacheHashAdd(CacheHash *hash, void *data, size_t len) {
+    unsigned char *p = (unsigned char *)data;
+    uint64_t hi = hash->hi;
+    uint64_t lo = hash->lo;
+    while (len--) {
+        lo ^= *p++;
+        // (hi, lo) * 0x13B, plus lo * 2^88, which only reaches hi
+        uint64_t carry = ((lo >> 32) * 0x13B + (((lo & 0xffffffffu) * 0x13B) >> 32)) >> 32;
+        hi = hi * 0x13B + carry + (lo << 24);
+        lo = lo * 0x13B;
+    }
+    hash->hi = hi;
+    hash->lo = lo;
+}
+
+// Add a string, terminator and all, so that no two lists of strings hash alike
+// by running together. NULL hashes apart from "".
+static void cacheHashStr(CacheHash *hash, char *str) {
+    char isset = str != NULL;
+    cacheHashAdd(hash, &isset, 1);
+    if (str)
+        cacheHashAdd(hash, str, strlen(str) + 1);
+}
+
+static void cacheHashInt(CacheHash *hash, int64_t n) {
+    cacheHashAdd(hash, &n, sizeof(n));
+}
+
+// Add a path the compile looked for source at, and what is there now
+static void cacheHashSrc(CacheHash *hash, char *path, char *src) {
+    cacheHashStr(hash, path);
+    cacheHashStr(hash, src);
+}
+
+// The hash's 32 hex digits, as a file name in the cache directory
+static char *cacheHashName(CacheHash *hash) {
+    char *name = memAllocStr(NULL, 32);
+    sprintf(name, "%016llx%016llx", (unsigned long long)hash->hi, (unsigned long long)hash->lo);
+    return name;
+}
+
+// Copy the file at from to a new file at to
+static int cacheCopy(char *from, char *to) {
+    FILE *in = fopen(from, "rb");
+    if (!in)
+        return 0;
+    FILE *out = fopen(to, "wb");
+    if (!out) {
+        fclose(in);
+        return 0;
+    }
+    char buf[65536];
+    size_t n;
+    int ok = 1;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        if (fwrite(buf, 1, n, out) != n) {
+            ok = 0;
+            break;
+        }
+    }
+    if (ferror(in))
+        ok = 0;
+    fclose(in);
+    if (fclose(out) != 0)
+        ok = 0;
+    return ok;
+}
+
+// Put a new file at path in the cache all at once, by way of a temporary copy
+// no other compile is writing, so no other compile can find half of it
+static int cachePut(char *path, char *from, char *text) {
+    char *tmp = memAllocStr(path, strlen(path) + 24);
+    sprintf(tmp + strlen(path), ".%d.tmp", (int)getpid());
+    int ok;
+    if (from)
+        ok = cacheCopy(from, tmp);
+    else {
+        FILE *out = fopen(tmp, "wb");
+        ok = out && fputs(text, out) >= 0;
+        if (out && fclose(out) != 0)
+            ok = 0;
+    }
+#ifdef _WIN32
+    if (ok)
+        remove(path);   // Windows' rename does not replace
+#endif
+    if (ok && rename(tmp, path) == 0)
+        return 1;
+    remove(tmp);
+    return 0;
+}
+
+// Create the cache directory, if it is not there yet
+static int cacheMakeDir(ConeOptions *opt) {
+    if (mkdir(opt->cache_dir, 0777) == 0 || errno == EEXIST)
+        return 1;
+    if (opt->verbosity > 0)
+        printf("Cannot create the object cache %s: %s\n", opt->cache_dir, strerror(errno));
+    return 0;
+}
+
+// The hash of the compiler's executable, started as argv0, as 32 hex digits,
+// or NULL if it cannot be found
+static char *cacheCompilerId(ConeOptions *opt, char *argv0) {
+    char *exe = fileExePath(argv0);
+    uint64_t size;
+    int64_t mtime;
+    if (exe == NULL || !fileStat(exe, &size, &mtime))
+        return NULL;
+    CacheHash stamp;
+    cacheHashInit(&stamp);
+    cacheHashStr(&stamp, exe);
+    cacheHashInt(&stamp, (int64_t)size);
+    cacheHashInt(&stamp, mtime);
+    char *idpath = fileMakePath(opt->cache_dir, cacheHashName(&stamp), "conec");
+    char *id = fileLoad(idpath);
+    if (id && strlen(id) == 32)
+        return id;
+
+    FILE *file = fopen(exe, "rb");
+    if (!file)
+        return NULL;
+    CacheHash contents;
+    cacheHashInit(&contents);
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+        cacheHashAdd(&contents, buf, n);
+    int ok = !ferror(file);
+    fclose(file);
+    if (!ok)
+        return NULL;
+    id = cacheHashName(&contents);
+    if (cacheMakeDir(opt))
+        cachePut(idpath, NULL, id);
+    return id;
+}
+
+// Everything besides the sources that the object depends on: the compiler, and
+// the options that change what it generates. The target options are as setup
+// resolved them, so a default CPU is the host's and not "whatever it was".
+static void cacheHashOptions(CacheHash *hash, ConeOptions *opt, char *compiler) {
+    cacheHashInit(hash);
+    cacheHashStr(hash, CONE_RELEASE);
+    cacheHashStr(hash, LLVM_VERSION_STRING);
+    cacheHashStr(hash, compiler);
+
+    cacheHashStr(hash, opt->srcpath);
+    cacheHashStr(hash, opt->triple);
+    cacheHashStr(hash, opt->cpu);
+    cacheHashStr(hash, opt->features);
+    cacheHashStr(hash, opt->passes);
+    cacheHashStr(hash, opt->linker);
+    cacheHashInt(hash, opt->opt_level);
+    cacheHashInt(hash, opt->release);
+    cacheHashInt(hash, opt->pic);
+    cacheHashInt(hash, opt->library);
+    cacheHashInt(hash, opt->wasm);
+    cacheHashInt(hash, opt->runtimebc);
+    cacheHashInt(hash, opt->codegen_units);
+    cacheHashInt(hash, opt->profile_generate);
+    cacheHashInt(hash, opt->extfun);
+    cacheHashInt(hash, opt->strip_debug);
+    cacheHashInt(hash, opt->simple_builtin);
+    for (char **path = opt->package_search_paths; path && *path; ++path)
+        cacheHashStr(hash, *path);
+}
+
+// Each path the missed compile looked for source at, in order, and what it found
+typedef struct {
+    char *path;
+    char *src;      // NULL if nothing was there
+} CacheSrc;
+
+static CacheSrc *cacheSrcs;
+static size_t cacheSrcCnt;
+static size_t cacheSrcAvail;
+
+static int cacheMissed;          // Whether the compile is one the cache missed, to store
+static CacheHash cacheOptHash;   // The options' hash, which the sources' are added to
+static char *cacheDepsPath;      // Where the missed compile's dependency list goes
+
+// fileLoadHook, while a compile the cache missed is loading its sources
+static void cacheLoaded(char *path, char *src) {
+    if (cacheSrcCnt == cacheSrcAvail) {
+        cacheSrcAvail = cacheSrcAvail ? cacheSrcAvail << 1 : 16;
+        CacheSrc *srcs = (CacheSrc *)memAllocBlk(cacheSrcAvail * sizeof(CacheSrc));
+        if (cacheSrcCnt)
+            memcpy(srcs, cacheSrcs, cacheSrcCnt * sizeof(CacheSrc));
+        cacheSrcs = srcs;
+    }
+    cacheSrcs[cacheSrcCnt].path = path;
+    cacheSrcs[cacheSrcCnt].src = src;
+    ++cacheSrcCnt;
+}
+
+// The path of the cached object whose key is hash, with objpath's extension
+static char *cacheObjPath(ConeOptions *opt, CacheHash *hash, char *objpath) {
+    char *ext = strrchr(objpath, '.');
+    return fileMakePath(opt->cache_dir, cacheHashName(hash), ext ? ext + 1 : "o");
+}
+
+// Whether the cache can stand in for this compile: one whose only output is
+// the object file, with nothing printed along the way. A profile is not a
+// source it tracks, so a compile that uses one is never cached.
+int cacheUsable(ConeOptions *opt) {
+    return opt->cache_dir && !opt->run && !opt->emit_bc && !opt->profile_use
+        && !opt->print_ir && !opt->print_asm && !opt->print_listing && !opt->print_llvmir
+        && !opt->print_stats && !opt->parse_trace && !opt->docs;
+}
+
+// Put the object the cache has for this source and its imports, as they are
+// now, at objpath. argv0 is how the compiler was started. Returns 1 if it did,
+// and the compile has nothing left to do. Otherwise, every source file the
+// compile loads is recorded for cacheStore.
+int cacheFetch(ConeOptions *opt, char *objpath, char *argv0) {
+    cacheMissed = 0;
+    char *compiler = cacheCompilerId(opt, argv0);
+    if (compiler == NULL) {
+        if (opt->verbosity > 0)
+            printf("Cannot find the compiler's executable, so the object cache is not used\n");
+        return 0;
+    }
+    cacheHashOptions(&cacheOptHash, opt, compiler);
+    cacheDepsPath = fileMakePath(opt->cache_dir, cacheHashName(&cacheOptHash), "deps");
+
+    // Each line of the dependency list is '+' or '-', for whether a source was
+    // found, then the path. What is at each path now is what counts.
+    char *deps = fileLoad(cacheDepsPath);
+    if (deps) {
+        CacheHash hash = cacheOptHash;
+        char *line = deps;
+        while (*line) {
+            char *end = strchr(line, '\n');
+            if (end == NULL)
+                break;
+            *end = '\0';
+            cacheHashSrc(&hash, line + 1, fileLoad(line + 1));
+            line = end + 1;
+        }
+        char *cached = cacheObjPath(opt, &hash, objpath);
+        if (*line == '\0' && cacheCopy(cached, objpath)) {
+            if (opt->verbosity > 0)
+                printf("Object cache hit for %s: %s\n", opt->srcpath, cached);
+            return 1;
+        }
+    }
+    if (opt->verbosity > 0)
+        printf("Object cache miss for %s\n", opt->srcpath);
+
+    cacheSrcCnt = 0;
+    cacheMissed = 1;
+    fileLoadHook = cacheLoaded;
+    return 0;
+}
+
+// Store the object at objpath, which the compile cacheFetch missed produced
+void cacheStore(ConeOptions *opt, char *objpath) {
+    fileLoadHook = NULL;
+    if (!cacheMissed)
+        return;
+
+    CacheHash hash = cacheOptHash;
+    size_t depslen = 1;
+    for (size_t i = 0; i < cacheSrcCnt; ++i) {
+        cacheHashSrc(&hash, cacheSrcs[i].path, cacheSrcs[i].src);
+        depslen += strlen(cacheSrcs[i].path) + 2;
+    }
+    char *deps = memAllocStr("", depslen);
+    char *p = deps;
+    for (size_t i = 0; i < cacheSrcCnt; ++i)
+        p += sprintf(p, "%c%s\n", cacheSrcs[i].src ? '+' : '-', cacheSrcs[i].path);
+
+    // The object goes first, so a list is never found without its object
+    char *cached = cacheObjPath(opt, &hash, objpath);
+    if (!cacheMakeDir(opt))
+        return;
+    if (!cachePut(cached, objpath, NULL) || !cachePut(cacheDepsPath, NULL, deps)) {
+        if (opt->verbosity > 0)
+            printf("Cannot store %s in the object cache\n", cached);
+        return;
+    }
+    if (opt->verbosity > 0)
+        printf("Object cache stored %s\n", cached);
+}
@@ -0,0 +1,26 @@
+/** Object cache, for --cache-dir
+ * @file
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#ifndef conecache_h
+#define conecache_h
+
+#include "coneopts.h"
+
+// Whether the cache can stand in for this compile: one whose only output is
+// the object file, with nothing printed along the way
+int cacheUsable(ConeOptions *opt);
+
+// Put the object the cache has for this source and its imports, as they are
+// now, at objpath. argv0 is how the compiler was started. Returns 1 if it did,
+// and the compile has nothing left to do. Otherwise, every source file the
+// compile loads is recorded for cacheStore.
+int cacheFetch(ConeOptions *opt, char *objpath, char *argv0);
+
+// Store the object at objpath, which the compile cacheFetch missed produced
+void cacheStore(ConeOptions *opt, char *objpath);
+
+#endif
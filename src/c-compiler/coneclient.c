@@ -0,0 +1,230 @@
+/** Compile client, for --client, and the protocol it speaks to a server
+ * @file
+ *
+ * A request is sent as its length, with the client's standard streams passed
+ * alongside it, then the client's working directory and its arguments, each
+ * null-terminated. The answer is the compile's exit status. See conesrv.c for
+ * the server's side.
+ *
+ * Nothing here needs the rest of the compiler, and built with
+ * CONE_CLIENT_MAIN defined this file is conec-client, the same client as
+ * conec --client, for callers that cannot afford conec's own start-up. conec
+ * links LLVM in, and takes longer to load than a small compile takes on a server.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "conesrv.h"
+#include "shared/error.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Return a socket listening at, or connected to, the Unix socket path, or -1.
+// A socket left at the path by a server that did not shut down is replaced.
+int srvSocket(char *path, int listening) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0)
+        return -1;
+    if (listening) {
+        unlink(path);
+        if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0 && listen(sock, SOMAXCONN) == 0)
+            return sock;
+    }
+    else if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+        return sock;
+    int err = errno;
+    close(sock);
+    errno = err;
+    return -1;
+}
+
+// Read exactly len bytes, or fail
+int srvRead(int sock, void *buf, size_t len) {
+    char *p = (char *)buf;
+    while (len > 0) {
+        ssize_t n = read(sock, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        p += n;
+        len -= n;
+    }
+    return 1;
+}
+
+// Write exactly len bytes, or fail
+int srvWrite(int sock, void *buf, size_t len) {
+    char *p = (char *)buf;
+    while (len > 0) {
+        ssize_t n = write(sock, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        p += n;
+        len -= n;
+    }
+    return 1;
+}
+
+// Send the request's length, and with it this process's standard streams
+static int srvSendStreams(int sock, uint32_t reqlen) {
+    int fds[3] = {0, 1, 2};
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+    struct iovec iov = {&reqlen, sizeof(reqlen)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    return sendmsg(sock, &msg, 0) == sizeof(reqlen);
+}
+
+// Receive the request's length and the client's standard streams
+int srvRecvStreams(int sock, uint32_t *reqlen, int fds[3]) {
+    char control[CMSG_SPACE(3 * sizeof(int))];
+    struct iovec iov = {reqlen, sizeof(*reqlen)};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(sock, &msg, 0) != sizeof(*reqlen))
+        return 0;
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS
+        || cmsg->cmsg_len != CMSG_LEN(3 * sizeof(int)))
+        return 0;
+    memcpy(fds, CMSG_DATA(cmsg), 3 * sizeof(int));
+    return 1;
+}
+
+// Have the server at the Unix socket path compile this command line, and
+// return the compile's exit status, or -1 if no server answers there
+int coneClient(char *path, int argc, char **argv) {
+    int sock = srvSocket(path, 0);
+    if (sock < 0)
+        return -1;
+
+    // Send the working directory and the command line, less the --client
+    // that sent it. What follows "--" is the program's, and goes as it is.
+    // This process ends soon, so nothing allocated here is freed.
+    char cwd[PATH_MAX];
+    if (getcwd(cwd, sizeof(cwd)) == NULL) {
+        close(sock);
+        return -1;
+    }
+    size_t reqlen = strlen(cwd) + 1;
+    char **args = malloc((argc + 1) * sizeof(char*));
+    int nargs = 0;
+    int progargs = 0;
+    for (int i = 0; i < argc; ++i) {
+        if (!progargs && i > 0) {
+            if (strcmp(argv[i], "--") == 0)
+                progargs = 1;
+            else if (strncmp(argv[i], "--client=", 9) == 0)
+                continue;
+            else if (strcmp(argv[i], "--client") == 0) {
+                ++i;
+                continue;
+            }
+        }
+        args[nargs++] = argv[i];
+        reqlen += strlen(argv[i]) + 1;
+    }
+    char *req = malloc(reqlen);
+    if (args == NULL || req == NULL) {
+        close(sock);
+        return -1;
+    }
+    char *p = req;
+    strcpy(p, cwd);
+    p += strlen(cwd) + 1;
+    for (int i = 0; i < nargs; ++i) {
+        strcpy(p, args[i]);
+        p += strlen(args[i]) + 1;
+    }
+
+    // Until the whole request is sent, nothing is compiled, and this process
+    // can still compile it. After, the server's answer is the only one.
+    if (!srvSendStreams(sock, (uint32_t)reqlen) || !srvWrite(sock, req, reqlen)) {
+        close(sock);
+        return -1;
+    }
+    int32_t status;
+    if (!srvRead(sock, &status, sizeof(status))) {
+        fprintf(stderr, "The compile server at %s stopped without an answer\n", path);
+        status = ExitGen;
+    }
+    close(sock);
+    return status;
+}
+
+#ifdef CONE_CLIENT_MAIN
+// conec-client takes conec's command line. It hands it to the server that
+// --client names, or if none answers, runs conec with it: the one beside
+// this executable, or else the one on the PATH.
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc && strcmp(argv[i], "--") != 0; ++i) {
+        char *path = NULL;
+        if (strncmp(argv[i], "--client=", 9) == 0)
+            path = argv[i] + 9;
+        else if (strcmp(argv[i], "--client") == 0 && i + 1 < argc)
+            path = argv[i + 1];
+        int status = path ? coneClient(path, argc, argv) : -1;
+        if (status >= 0)
+            return status;
+    }
+
+    char conec[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", conec, sizeof(conec) - sizeof("conec"));
+    if (len > 0) {
+        conec[len] = '\0';
+        char *slash = strrchr(conec, '/');
+        strcpy(slash ? slash + 1 : conec, "conec");
+        argv[0] = conec;
+        execv(conec, argv);
+    }
+    argv[0] = "conec";
+    execvp("conec", argv);
+    fprintf(stderr, "Cannot run conec: %s\n", strerror(errno));
+    return ExitGen;
+}
+#endif
+
+#else
+
+// With no server possible, the client compiles on its own
+int coneClient(char *path, int argc, char **argv) {
+    return -1;
+}
+
+#endif
@@ -20,6 +20,8 @@ enum
     OPT_VERSION,
     OPT_HELP,
     OPT_DEBUG,
+    OPT_OPTLEVEL,
+    OPT_PASSES,
     OPT_BUILDFLAG,
     OPT_STRIP,
     OPT_PATHS,
@@ -30,6 +32,15 @@ enum
     OPT_NOPIC,
     OPT_DOCS,
     OPT_DOCS_PUBLIC,
+    OPT_CODEGEN_UNITS,
+    OPT_RUN,
+    OPT_SERVER,
+    OPT_CLIENT,
+    OPT_CACHE_DIR,
+    OPT_EMIT,
+    OPT_LTO,
+    OPT_PROFILE_GENERATE,
+    OPT_PROFILE_USE,
 
     OPT_SAFE,
     OPT_CPU,
@@ -37,14 +48,17 @@ enum
     OPT_WASM,
     OPT_TRIPLE,
     OPT_STATS,
+    OPT_ARENA,
     OPT_LINK_ARCH,
     OPT_LINKER,
 
     OPT_VERBOSE,
     OPT_IR,
     OPT_ASM,
+    OPT_LISTING,
     OPT_LLVMIR,
     OPT_TRACE,
+    OPT_TIME_TRACE,
     OPT_WIDTH,
     OPT_IMMERR,
     OPT_VERIFY,
@@ -64,6 +78,8 @@ static opt_arg_t args[] =
     { "version", 'v', OPT_ARG_NONE, OPT_VERSION },
     { "help", 'h', OPT_ARG_NONE, OPT_HELP },
     { "debug", 'd', OPT_ARG_NONE, OPT_DEBUG },
+    { "opt", 'O', OPT_ARG_REQUIRED, OPT_OPTLEVEL },
+    { "passes", '\0', OPT_ARG_REQUIRED, OPT_PASSES },
     { "define", 'D', OPT_ARG_REQUIRED, OPT_BUILDFLAG },
     { "strip", 's', OPT_ARG_NONE, OPT_STRIP },
     { "path", 'p', OPT_ARG_REQUIRED, OPT_PATHS },
@@ -74,6 +90,15 @@ static opt_arg_t args[] =
     { "nopic", '\0', OPT_ARG_NONE, OPT_NOPIC },
     { "docs", 'g', OPT_ARG_NONE, OPT_DOCS },
     { "docs-public", '\0', OPT_ARG_NONE, OPT_DOCS_PUBLIC },
+    { "codegen-units", 'j', OPT_ARG_REQUIRED, OPT_CODEGEN_UNITS },
+    { "run", 'r', OPT_ARG_NONE, OPT_RUN },
+    { "server", '\0', OPT_ARG_REQUIRED, OPT_SERVER },
+    { "client", '\0', OPT_ARG_REQUIRED, OPT_CLIENT },
+    { "cache-dir", '\0', OPT_ARG_REQUIRED, OPT_CACHE_DIR },
+    { "emit", '\0', OPT_ARG_REQUIRED, OPT_EMIT },
+    { "lto", '\0', OPT_ARG_NONE, OPT_LTO },
+    { "profile-generate", '\0', OPT_ARG_NONE, OPT_PROFILE_GENERATE },
+    { "profile-use", '\0', OPT_ARG_REQUIRED, OPT_PROFILE_USE },
 
     { "safe", '\0', OPT_ARG_OPTIONAL, OPT_SAFE },
     { "cpu", '\0', OPT_ARG_REQUIRED, OPT_CPU },
@@ -81,14 +106,17 @@ static opt_arg_t args[] =
     { "wasm", '\0', OPT_ARG_NONE, OPT_WASM },
     { "triple", '\0', OPT_ARG_REQUIRED, OPT_TRIPLE },
     { "stats", '\0', OPT_ARG_NONE, OPT_STATS },
+    { "arena", '\0', OPT_ARG_REQUIRED, OPT_ARENA },
     { "link-arch", '\0', OPT_ARG_REQUIRED, OPT_LINK_ARCH },
     { "linker", '\0', OPT_ARG_REQUIRED, OPT_LINKER },
 
     { "verbose", 'V', OPT_ARG_REQUIRED, OPT_VERBOSE },
     { "ir", '\0', OPT_ARG_NONE, OPT_IR },
     { "asm", '\0', OPT_ARG_NONE, OPT_ASM },
+    { "listing", '\0', OPT_ARG_NONE, OPT_LISTING },
     { "llvmir", '\0', OPT_ARG_NONE, OPT_LLVMIR },
     { "trace", 't', OPT_ARG_NONE, OPT_TRACE },
+    { "time-trace", '\0', OPT_ARG_REQUIRED, OPT_TIME_TRACE },
     { "width", 'w', OPT_ARG_REQUIRED, OPT_WIDTH },
     { "immerr", '\0', OPT_ARG_NONE, OPT_IMMERR },
     { "verify", '\0', OPT_ARG_NONE, OPT_VERIFY },
@@ -104,14 +132,23 @@ static opt_arg_t args[] =
 static void usage()
 {
     printf("%s\n%s\n%s\n%s\n%s\n%s", // for complying with -Woverlength-strings
-        "cone [OPTIONS] <source_file>\n"
+        "cone [OPTIONS] <source_file> [-- program arguments]\n"
         ,
         "The source directory defaults to the current directory.\n"
         ,
         "Options:\n"
         "  --version, -v   Print the version of the compiler and exit.\n"
         "  --help, -h      Print this help text and exit.\n"
-        "  --debug, -d     Don't optimise the output.\n"
+        "  --debug, -d     Don't optimise the output, and generate debug info.\n"
+        "  --opt, -O       Optimization level.\n"
+        "    =0            None. The default with --debug.\n"
+        "    =1            Fast debug: cheap optimizations only.\n"
+        "    =2            Standard optimization. The default.\n"
+        "    =3            Aggressive optimization.\n"
+        "    =s            Optimize for size.\n"
+        "    =z            Optimize for size above all.\n"
+        "  --passes        Run this LLVM pass pipeline instead of the --opt level's.\n"
+        "    =pipeline     e.g., 'function(sroa,instcombine,simplifycfg)'.\n"
         "  --define, -D    Define the specified build flag.\n"
         "    =name\n"
         "  --strip, -s     Strip debug info.\n"
@@ -120,28 +157,62 @@ static void usage()
         "  --output, -o    Write output to this directory.\n"
         "    =path         Defaults to the current directory.\n"
         "  --library, -l   Generate a C-API compatible static library.\n"
-        "  --runtimebc     Compile with the LLVM bitcode file for the runtime.\n"
+        "  --runtimebc     With --lto, link and optimize the runtime's bitcode too.\n"
+        "                  conestd.bc is found beside conec, where the build puts it.\n"
         "  --wasm          Compile for WebAssembly target.\n"
         "  --pic           Compile using position independent code.\n"
         "  --nopic         Don't compile using position independent code.\n"
         "  --docs, -g      Generate code documentation.\n"
         "  --docs-public   Generate code documentation for public types only.\n"
+        "  --codegen-units, -j\n"
+        "    =N            Optimize and generate code on N threads (default 1).\n"
+        "                  The units' objects are combined with --linker -r.\n"
+        "  --run, -r       Compile in memory and run the program, writing no object.\n"
+        "                  Arguments after the source file, or after --, are its.\n"
+        "                  Exits with the status main returns.\n"
+        "  --server        Set up once, then serve compiles until killed.\n"
+        "    =socket       The Unix socket to serve at. No source file is given.\n"
+        "  --client        Have a server compile this, as if it were compiled here.\n"
+        "    =socket       The server's socket. With no server there, compile here.\n"
+        "  --cache-dir     Reuse the object an earlier compile of the same sources made.\n"
+        "    =path         Where objects are kept. Not used with --run or --asm,\n"
+        "                  or with any other output besides the object.\n"
+        "  --emit          What to write for the program.\n"
+        "    =obj          An object file. The default.\n"
+        "    =bc           LLVM bitcode, for --lto to optimize with the rest.\n"
+        "  --lto           Link the LLVM bitcode files given, not a source, and\n"
+        "                  optimize them as one program before writing its object.\n"
+        "                  Only main stays visible outside it, or with --library,\n"
+        "                  every function that is public.\n"
+        "  --profile-generate\n"
+        "                  Count how often each function, branch and call runs.\n"
+        "                  Link with clang -fprofile-instr-generate, and the run\n"
+        "                  writes default.profraw for llvm-profdata to merge.\n"
+        "  --profile-use   Optimize with the counts profiled runs recorded, for\n"
+        "    =file         inlining and block layout. A merged .profdata file.\n"
         ,
         "Rarely needed options:\n"
         "  --safe          Allow only the listed packages to use C FFI.\n"
         "    =package      With no packages listed, only builtin is allowed.\n"
         "  --cpu           Set the target CPU.\n"
-        "    =name         Default is the host CPU.\n"
+        "    =name         Default is native, or generic when cross-compiling.\n"
+        "    =native       The host CPU, with all the features the host detects.\n"
+        "    =x86-64-v2    SSE4.2 and POPCNT. v3 adds AVX2, BMI and FMA; v4 AVX-512.\n"
         "  --features      CPU features to enable or disable.\n"
         "    =+this,-that  Use + to enable, - to disable.\n"
-        "                  Defaults to detecting all CPU features from the host.\n"
+        "                  Applied after those --cpu=native detects.\n"
         "  --triple        Set the target triple.\n"
         "    =name         Defaults to the host triple.\n"
-        "  --stats         Print some compiler stats.\n"
+        "  --stats         Print some compiler stats, memory use among them.\n"
+        "  --arena         Where the compiler gets its own memory from.\n"
+        "    =malloc       An arena malloc'd at a time, as needed (default).\n"
+        "    =reserve      One large address range, reserved up front.\n"
+        "    =huge         The same, on transparent huge pages where there are any.\n"
+        "                  CONE_ARENA in the environment sets the default.\n"
         "  --link-arch     Set the linking architecture.\n"
         "    =name         Default is the host architecture.\n"
         "  --linker        Set the linker command to use.\n"
-        "    =name         Default is the compiler.\n"
+        "    =name         Default is the compiler ('ld' for --codegen-units).\n"
         ,
         "Debugging options:\n"
         "  --verbose, -V   Verbosity level.\n"
@@ -151,9 +222,12 @@ static void usage()
         "    =3            External tool command lines.\n"
         "    =4            Very low-level detail.\n"
         "  --ir            Output an IR tree for the whole program.\n"
-        "  --asm           Output an assembly file.\n"
+        "  --asm           Output the module's assembly.\n"
+        "  --listing       Output a disassembly listing of the object.\n"
         "  --llvmir        Output an LLVM IR file.\n"
         "  --trace, -t     Enable parse trace.\n"
+        "  --time-trace    Write where the compile's time went, as Chrome trace events.\n"
+        "    =file         Open it in chrome://tracing or Perfetto.\n"
         "  --width, -w     Width to target when printing the IR.\n"
         "    =columns      Defaults to the terminal width.\n"
         "  --immerr        Report errors immediately rather than deferring.\n"
@@ -168,6 +242,35 @@ static void usage()
     );
 }
 
+// The arena kind an --arena or CONE_ARENA value names, or -1 if none
+static int coneOptArena(char *kind) {
+    if (strcmp(kind, "malloc") == 0)
+        return 0;
+    if (strcmp(kind, "reserve") == 0)
+        return 1;
+    if (strcmp(kind, "huge") == 0)
+        return 2;
+    return -1;
+}
+
+// The arena kind CONE_ARENA and argv choose, found before coneOptSet runs, so
+// that a reserved range can be in place before the first allocation. What
+// either gets wrong is left for coneOptSet to report.
+int coneOptArenaFirst(int argc, char **argv) {
+    char *arenaenv = getenv("CONE_ARENA");
+    int arena = arenaenv && *arenaenv ? coneOptArena(arenaenv) : 0;
+    for (int i = 1; i < argc && strcmp(argv[i], "--") != 0; ++i) {
+        char *kind = NULL;
+        if (strncmp(argv[i], "--arena=", 8) == 0)
+            kind = argv[i] + 8;
+        else if (strcmp(argv[i], "--arena") == 0 && i + 1 < argc)
+            kind = argv[++i];
+        if (kind)
+            arena = coneOptArena(kind);
+    }
+    return arena > 0 ? arena : 0;
+}
+
 // Handle creation of package_search_paths array of strings
 void coneOptPath(char *path, ConeOptions *opt) {
     // Create package_search_paths based on count of semi-colon separated paths
@@ -211,14 +314,35 @@ int coneOptSet(ConeOptions *opt, int *argc, char **argv) {
 
     memset(opt, 0, sizeof(ConeOptions));
     opt->verbosity = 0;
+
+    // The environment can choose the arena, so it can be compared without
+    // changing every command line; --arena overrides it
+    char *arenaenv = getenv("CONE_ARENA");
+    if (arenaenv && *arenaenv && (opt->arena = coneOptArena(arenaenv)) < 0) {
+        printf("Unrecognised CONE_ARENA: %s\n", arenaenv);
+        ok = 0;
+    }
     // options->limit = PASS_ALL;
     // options->check.errors = errors_alloc();
 
+    // What follows "--" is the program's, for --run, even where it looks like an option
+    int progargs = 0;
+    int progstart = 0;
+    for (i = 1; i < *argc; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            progstart = i + 1;
+            progargs = *argc - progstart;
+            *argc = i;
+            break;
+        }
+    }
+
     optInit(args, &s, argc, argv);
 #if CONE_DEFAULT_PIC
     opt.pic = 1;
 #endif
     opt->release = 1;
+    opt->codegen_units = 1;
     opt->package_search_paths = NULL;
 
     while ((id = optNext(&s)) != -1) {
@@ -232,6 +356,13 @@ int coneOptSet(ConeOptions *opt, int *argc, char **argv) {
             return 0;
 
         case OPT_DEBUG: opt->release = 0; break;
+        case OPT_OPTLEVEL:
+            if (strlen(s.arg_val) == 1 && strchr("0123sz", s.arg_val[0]))
+                opt->opt_level = s.arg_val[0];
+            else
+                ok = 0;
+            break;
+        case OPT_PASSES: opt->passes = s.arg_val; break;
         case OPT_STRIP: opt->strip_debug = 1; break;
         case OPT_OUTPUT: opt->output = s.arg_val; break;
         case OPT_LIBRARY: opt->library = 1; break;
@@ -250,6 +381,30 @@ int coneOptSet(ConeOptions *opt, int *argc, char **argv) {
             opt->docs_private = 1;
         }
         break;
+        case OPT_CODEGEN_UNITS:
+        {
+            int n = atoi(s.arg_val);
+            if (n >= 1 && n <= 256)
+                opt->codegen_units = n;
+            else
+                ok = 0;
+        }
+        break;
+        case OPT_RUN: opt->run = 1; break;
+        case OPT_SERVER: opt->server = s.arg_val; break;
+        case OPT_CLIENT: opt->client = s.arg_val; break;
+        case OPT_CACHE_DIR: opt->cache_dir = s.arg_val; break;
+        case OPT_EMIT:
+            if (strcmp(s.arg_val, "bc") == 0)
+                opt->emit_bc = 1;
+            else if (strcmp(s.arg_val, "obj") == 0)
+                opt->emit_bc = 0;
+            else
+                ok = 0;
+            break;
+        case OPT_LTO: opt->lto = 1; break;
+        case OPT_PROFILE_GENERATE: opt->profile_generate = 1; break;
+        case OPT_PROFILE_USE: opt->profile_use = s.arg_val; break;
         case OPT_BUILDFLAG:
             // define_build_flag(s.arg_val); 
             break;
@@ -266,13 +421,19 @@ int coneOptSet(ConeOptions *opt, int *argc, char **argv) {
         case OPT_FEATURES: opt->features = s.arg_val; break;
         case OPT_TRIPLE: opt->triple = s.arg_val; break;
         case OPT_STATS: opt->print_stats = 1; break;
+        case OPT_ARENA:
+            if ((opt->arena = coneOptArena(s.arg_val)) < 0)
+                ok = 0;
+            break;
         case OPT_LINK_ARCH: opt->link_arch = s.arg_val; break;
         case OPT_LINKER: opt->linker = s.arg_val; break;
 
         case OPT_IR: opt->print_ir = 1; break;
         case OPT_ASM: opt->print_asm = 1; break;
+        case OPT_LISTING: opt->print_listing = 1; break;
         case OPT_LLVMIR: opt->print_llvmir = 1; break;
         case OPT_TRACE: opt->parse_trace = 1; break;
+        case OPT_TIME_TRACE: opt->time_trace = s.arg_val; break;
         case OPT_WIDTH: opt->ir_print_width = atoi(s.arg_val); break;
             // case OPT_IMMERR: errors_set_immediate(opt.check.errors, 1); break;
         case OPT_VERIFY: opt->verify = 1; break;
@@ -296,6 +457,10 @@ int coneOptSet(ConeOptions *opt, int *argc, char **argv) {
         }
     }
 
+    // --debug means no optimization, unless --opt asks for some anyway
+    if (opt->opt_level == '\0')
+        opt->opt_level = opt->release? '2' : '0';
+
     for (i = 1; i < *argc; i++) {
         if (argv[i][0] == '-') {
             printf("Unrecognised option: %s\n", argv[i]);
@@ -304,6 +469,14 @@ int coneOptSet(ConeOptions *opt, int *argc, char **argv) {
         }
     }
 
+    // Give the program its arguments back, after the source file and any
+    // others the options left, in place of the "--"
+    if (progstart) {
+        memmove(&argv[*argc], &argv[progstart], progargs * sizeof(char*));
+        *argc += progargs;
+        argv[*argc] = NULL;
+    }
+
     if (!ok) {
         // errors_print(opt.check.errors);
         if (print_usage)
@@ -34,12 +34,25 @@ typedef struct ConeOptions {
     void* data; // User-defined data for unit test callbacks
 
     int ptrsize;    // Size of a pointer (in bits)
+    char *passes;   // LLVM pass pipeline to run instead of the --opt level's
+    char opt_level; // '0'-'3', 's' or 'z'
+    int codegen_units;    // Partitions LLVM optimizes and emits in parallel (1 = no split)
+    int run;        // 1=compile into memory and run the program, instead of writing an object
+    char *server;   // Unix socket to serve compiles at, instead of compiling
+    char *client;   // Unix socket of a server to compile this instead
+    char *cache_dir;    // Directory of objects to reuse, when their sources have not changed
+    char *time_trace;   // File to write Chrome trace events to, for where the compile's time went
+    int arena;      // 0=malloc'd arenas, 1=one reserved address range, 2=the same on huge pages
+    int emit_bc;    // 1=write LLVM bitcode, optimized to be optimized again at link time, not an object
+    int lto;        // 1=link the bitcode files given and optimize them as one program, instead of compiling
+    int profile_generate;   // 1=instrument the program to count what runs, for --profile-use
+    char *profile_use;      // Merged profile of what ran, to optimize with
 
     // Boolean flags
     int wasm;        // 1=WebAssembly
     int release;    // 0=debug (no optimizations). 1=release (default)
     int library;    // 1=generate a C-API compatible static library
-    int runtimebc;    // Compile with the LLVM bitcode file for the runtime
+    int runtimebc;    // With lto, link in the LLVM bitcode file for the runtime too
     int pic;        // Compile using position independent code
     int print_stats;    // Print some compiler statistics
     int verify;        // Verify LLVM IR
@@ -49,6 +62,7 @@ typedef struct ConeOptions {
     int print_filenames;    // Print source file names as each is processed
     int print_ir;        // Print out IR
     int print_asm;        // Print out assembly file
+    int print_listing;    // Print out a disassembly listing of the object
     int print_llvmir;    // Print out LLVM IR
     int check_tree;        // Verify IR well-formedness
     int lint_llvm;        // Run the LLVM linting pass on generated IR
@@ -64,5 +78,6 @@ typedef struct ConeOptions {
 } ConeOptions;
 
 int coneOptSet(ConeOptions *opt, int *argc, char **argv);
+int coneOptArenaFirst(int argc, char **argv);
 
 #endif
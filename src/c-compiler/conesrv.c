@@ -0,0 +1,172 @@
+/** Compile server, for --server and --client
+ * @file
+ *
+ * Much of what a small compile costs is the same every time: initializing
+ * LLVM's targets, making a target machine, filling the name table and parsing
+ * the core library. A server does that once and then waits on a Unix socket.
+ * Each request is compiled by a process forked from the server, which starts
+ * from the server's state exactly as setup left it. Copy-on-write is what makes
+ * that snapshot, and it is pristine for every request, since nothing a compile
+ * adds to the name table or the arena ever reaches the server.
+ *
+ * A client sends its working directory and command line, along with its
+ * standard streams, so the compile reads and writes the client's own files and
+ * terminal. It then exits with the status the compile exited with. The
+ * client, and the protocol, are in coneclient.c.
+ *
+ * Requests are served one process apiece: a handler receives the request and
+ * waits on the compile it forks, because a compile stops by calling exit
+ * wherever it stops, and only its parent can learn the status.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "conesrv.h"
+#include "shared/error.h"
+#include "shared/fileio.h"
+#include "shared/memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+// No command line is anywhere near this long. Anything longer is not a client.
+#define SrvMaxRequest (1 << 20)
+
+// Path to this executable, for a request the server's setup does not suit
+static char *srvExe;
+
+// Compile one request, in the process forked for it, on the client's streams
+static void srvCompile(char *cwd, int argc, char **argv, int fds[3], ConeServeFn compile) {
+    for (int fd = 0; fd < 3; ++fd) {
+        dup2(fds[fd], fd);
+        if (fds[fd] > 2)
+            close(fds[fd]);
+    }
+    if (chdir(cwd) != 0)
+        errorExit(ExitNF, "Cannot compile in %s: %s", cwd, strerror(errno));
+
+    // The compile parses its options out of its copy of the command line,
+    // which it rewrites, short options and all
+    char **compileargv = memAllocBlk((argc + 1) * sizeof(char*));
+    for (int i = 0; i < argc; ++i)
+        compileargv[i] = memAllocStr(argv[i], strlen(argv[i]));
+    compileargv[argc] = NULL;
+    int status = compile(argc, compileargv);
+
+    // A compile that returns is done. Nothing needs running down at exit, and
+    // skipping LLVM's static destructors takes a noticeable share of a small compile.
+    if (status >= 0) {
+        fflush(NULL);
+        _exit(status);
+    }
+
+    // Another target means another core library, so this one starts afresh
+    fflush(NULL);
+    argv[0] = srvExe;
+    execv(srvExe, argv);
+    errorExit(ExitOpts, "Cannot start %s to compile for this target: %s", srvExe, strerror(errno));
+}
+
+// Serve one connection: receive its request, compile it, and answer with the status
+static int srvHandle(int conn, ConeServeFn compile) {
+    // The server leaves its children to the system, but this one waits on its own
+    signal(SIGCHLD, SIG_DFL);
+
+    // The request is the client's working directory, then its arguments,
+    // each null-terminated
+    uint32_t reqlen;
+    int fds[3];
+    if (!srvRecvStreams(conn, &reqlen, fds) || reqlen == 0 || reqlen > SrvMaxRequest)
+        return 1;
+    char *req = memAllocBlk(reqlen + 1);
+    if (!srvRead(conn, req, reqlen))
+        return 1;
+    req[reqlen] = '\0';
+    int argc = -1;
+    for (uint32_t i = 0; i < reqlen; ++i) {
+        if (req[i] == '\0')
+            ++argc;
+    }
+    if (argc < 1 || req[reqlen - 1] != '\0')
+        return 1;
+    char **argv = memAllocBlk((argc + 1) * sizeof(char*));
+    char *p = req + strlen(req) + 1;
+    for (int i = 0; i < argc; ++i) {
+        argv[i] = p;
+        p += strlen(p) + 1;
+    }
+    argv[argc] = NULL;
+
+    pid_t pid = fork();
+    if (pid < 0)
+        return 1;
+    if (pid == 0) {
+        close(conn);
+        srvCompile(req, argc, argv, fds, compile);
+    }
+
+    // The client's streams are the compile's alone now, so they close with it.
+    // A compile killed by a signal reports as a shell would.
+    for (int fd = 0; fd < 3; ++fd)
+        close(fds[fd]);
+    int wstatus;
+    while (waitpid(pid, &wstatus, 0) < 0) {
+        if (errno != EINTR)
+            return 1;
+    }
+    int32_t status = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 128 + WTERMSIG(wstatus);
+    return srvWrite(conn, &status, sizeof(status)) ? 0 : 1;
+}
+
+// Serve compiles at the Unix socket path, each by a process forked from this
+// one as it is now. exe is how this executable was started. Never returns.
+void coneServe(char *path, char *exe, ConeServeFn compile) {
+    // A request for another target is compiled by a fresh copy of this
+    // executable, found as the server found it, whatever directory it is in
+    srvExe = fileExePath(exe);
+    if (srvExe == NULL)
+        srvExe = exe;
+
+    int listener = srvSocket(path, 1);
+    if (listener < 0)
+        errorExit(ExitOpts, "Cannot serve compiles at %s: %s", path, strerror(errno));
+
+    // Nothing is waited on here, so the system reaps every handler
+    signal(SIGCHLD, SIG_IGN);
+    fprintf(stderr, "Serving compiles at %s\n", path);
+    fflush(NULL);   // Or every compile would inherit, and write, what is buffered
+
+    while (1) {
+        int conn = accept(listener, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            errorExit(ExitOpts, "Cannot serve compiles at %s: %s", path, strerror(errno));
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(listener);
+            _exit(srvHandle(conn, compile));    // As a compile does, for the same reason
+        }
+        close(conn);    // The handler has its own; if fork failed, the client is told nothing
+    }
+}
+
+#else
+
+// Windows has Unix domain sockets but no fork, and fork is what makes the snapshot
+void coneServe(char *path, char *exe, ConeServeFn compile) {
+    errorExit(ExitOpts, "--server needs fork, which Windows does not have");
+}
+
+#endif
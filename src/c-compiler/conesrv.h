@@ -0,0 +1,35 @@
+/** Compile server and client
+ * @file
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#ifndef conesrv_h
+#define conesrv_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// A server's compile of one request, run with the request's command line in a
+// process forked for it. Returns the exit status, or -1 if the server's setup
+// does not suit the request's options and it must be compiled from scratch.
+typedef int (*ConeServeFn)(int argc, char **argv);
+
+// Serve compiles at the Unix socket path, each by a process forked from this
+// one as it is now. exe is how this executable was started. Never returns.
+void coneServe(char *path, char *exe, ConeServeFn compile);
+
+// Have the server at the Unix socket path compile this command line, and
+// return the compile's exit status, or -1 if no server answers there
+int coneClient(char *path, int argc, char **argv);
+
+// The protocol both ends speak (coneclient.c). srvSocket returns a socket
+// listening at, or connected to, the Unix socket path, or -1. The others
+// return 1, or 0 if the connection failed.
+int srvSocket(char *path, int listening);
+int srvRead(int sock, void *buf, size_t len);
+int srvWrite(int sock, void *buf, size_t len);
+int srvRecvStreams(int sock, uint32_t *reqlen, int fds[3]);
+
+#endif
@@ -302,7 +302,8 @@ void genlDealiasNodes(GenState *gen, Nodes *nodes) {
             VarDclNode *var = (VarDclNode *)*nodesp;
             RefNode *reftype = (RefNode *)var->vtype;
             if (reftype->tag == RefTag) {
-                LLVMValueRef ref = LLVMBuildLoad(gen->builder, var->llvmvar, "allocref");
+                LLVMValueRef ref = genlVarIsValue(var) ? var->llvmvar
+                    : LLVMBuildLoad(gen->builder, var->llvmvar, "allocref");
                 if (isRegion(reftype->region, soName)) {
                     genlDealiasOwn(gen, ref, reftype);
                 }
@@ -0,0 +1,241 @@
+/** Function multiversioning, for '@target_clones'
+ * @file
+ *
+ * A function declared with '@target_clones("avx2", "default")' is generated
+ * once per feature set, each version an internal function compiled with those
+ * extra CPU features. A resolver asks the runtime which features the CPU has
+ * (conestd's coneCpuFeatures) and returns the best version it can run.
+ *
+ * The public symbol is how callers reach it. Where the object format has
+ * indirect functions (ELF), it is an ifunc, which the loader resolves once
+ * while it relocates the program. Elsewhere it is a small function that
+ * resolves on its first call, caches the answer, and calls through it. So is
+ * a program's under --run, whose JIT does not resolve ifuncs.
+ *
+ * The feature names are x86's, so other targets get the default version alone,
+ * under the public symbol, exactly as if the attribute were not there.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "../ir/ir.h"
+#include "../shared/memory.h"
+#include "../coneopts.h"
+#include "genllvm.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// One version of a multiversioned function
+typedef struct GenlClone {
+    int32_t mask;          // Bits of fnCloneFeatures it requires (0 for "default")
+    LLVMValueRef fn;       // The internal function holding this version's body
+} GenlClone;
+
+// Can this target choose a version at run time? The features are x86's.
+static int genlClonesSupported(char *triple) {
+    return strncmp(triple, "x86_64", 6) == 0 || strncmp(triple, "amd64", 5) == 0
+        || (triple[0] == 'i' && triple[1] >= '3' && triple[1] <= '6' && strncmp(triple + 2, "86", 2) == 0);
+}
+
+// Does the target's object format have indirect functions? Only ELF does.
+static int genlClonesIfunc(char *triple) {
+    return !(strstr(triple, "darwin") || strstr(triple, "apple") || strstr(triple, "macos")
+        || strstr(triple, "windows") || strstr(triple, "win32") || strstr(triple, "mingw")
+        || strstr(triple, "cygwin") || strstr(triple, "wasm"));
+}
+
+// Index of a mask's newest feature, which is what ranks a version
+static int genlCloneTop(int32_t mask) {
+    int top = -1;
+    while (mask) {
+        mask >>= 1;
+        ++top;
+    }
+    return top;
+}
+
+// Order versions from least to most preferred: by newest feature required,
+// then by how many features, so "avx2+fma" outranks "avx2"
+static int genlCloneCmp(const void *a, const void *b) {
+    int32_t amask = ((GenlClone *)a)->mask;
+    int32_t bmask = ((GenlClone *)b)->mask;
+    int atop = genlCloneTop(amask);
+    int btop = genlCloneTop(bmask);
+    if (atop != btop)
+        return atop < btop? -1 : 1;
+    int acnt = 0, bcnt = 0;
+    for (; amask; amask &= amask - 1)
+        ++acnt;
+    for (; bmask; bmask &= bmask - 1)
+        ++bcnt;
+    return acnt < bcnt? -1 : acnt > bcnt;
+}
+
+// Return a copy of a symbol's name, with a suffix appended
+static char *genlCloneName(char *name, size_t namelen, char *sep, char *suffix, uint32_t suffixlen) {
+    size_t seplen = strlen(sep);
+    char *clonename = memAllocStr(NULL, namelen + seplen + suffixlen);
+    memcpy(clonename, name, namelen);
+    memcpy(clonename + namelen, sep, seplen);
+    memcpy(clonename + namelen + seplen, suffix, suffixlen);
+    clonename[namelen + seplen + suffixlen] = '\0';
+    return clonename;
+}
+
+// The target features a version is compiled with: the build's, plus its own
+static char *genlCloneFeatures(char *features, int32_t mask) {
+    size_t len = strlen(features);
+    for (int bit = 0; fnCloneFeatures[bit]; ++bit) {
+        if (mask & (1 << bit))
+            len += strlen(fnCloneFeatures[bit]) + 2;
+    }
+    char *clonefeatures = memAllocStr(features, len);
+    for (int bit = 0; fnCloneFeatures[bit]; ++bit) {
+        if (mask & (1 << bit)) {
+            if (*clonefeatures)
+                strcat(clonefeatures, ",");
+            strcat(clonefeatures, "+");
+            strcat(clonefeatures, fnCloneFeatures[bit]);
+        }
+    }
+    return clonefeatures;
+}
+
+// Generate the resolver, which returns the most preferred version the CPU can run.
+// The versions are in ascending order of preference, so each test that passes
+// overrides the choice of every test before it.
+static LLVMValueRef genlClonesResolver(GenState *gen, char *name, size_t namelen,
+    LLVMTypeRef fnty, GenlClone *versions, uint32_t nversions) {
+    LLVMTypeRef fnptr = LLVMPointerType(fnty, 0);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(gen->context);
+    LLVMValueRef resolver = LLVMAddFunction(gen->module, genlCloneName(name, namelen, ".", "resolver", 8),
+        LLVMFunctionType(fnptr, NULL, 0, 0));
+    LLVMSetLinkage(resolver, LLVMInternalLinkage);
+    genlTargetAttrs(gen, resolver, gen->opt->features);
+    genlComdat(gen, resolver);
+
+    LLVMValueRef cpufn = LLVMGetNamedFunction(gen->module, "coneCpuFeatures");
+    if (!cpufn)
+        cpufn = LLVMAddFunction(gen->module, "coneCpuFeatures", LLVMFunctionType(i64, NULL, 0, 0));
+
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(gen->context);
+    LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(gen->context, resolver, "entry"));
+    LLVMValueRef cpu = LLVMBuildCall2(builder, LLVMFunctionType(i64, NULL, 0, 0), cpufn, NULL, 0, "cpu");
+    LLVMValueRef best = versions[0].fn;   // "default", which needs nothing
+    for (uint32_t i = 1; i < nversions; ++i) {
+        LLVMValueRef need = LLVMConstInt(i64, (unsigned long long)versions[i].mask, 0);
+        LLVMValueRef has = LLVMBuildICmp(builder, LLVMIntEQ, LLVMBuildAnd(builder, cpu, need, ""), need, "");
+        best = LLVMBuildSelect(builder, has, versions[i].fn, best, "");
+    }
+    LLVMBuildRet(builder, best);
+    LLVMDisposeBuilder(builder);
+    return resolver;
+}
+
+// Give the public function a body that calls the version the resolver chooses.
+// The first call resolves it and caches the answer for every call after.
+// A race between two first calls is harmless: both store the same pointer.
+static void genlClonesStub(GenState *gen, LLVMValueRef pub, char *name, size_t namelen,
+    LLVMTypeRef fnty, LLVMValueRef resolver) {
+    LLVMTypeRef fnptr = LLVMPointerType(fnty, 0);
+    unsigned align = LLVMABIAlignmentOfType(gen->datalayout, fnptr);
+    LLVMValueRef cache = LLVMAddGlobal(gen->module, fnptr, genlCloneName(name, namelen, ".", "version", 7));
+    LLVMSetInitializer(cache, LLVMConstNull(fnptr));
+    LLVMSetLinkage(cache, LLVMInternalLinkage);
+    genlComdat(gen, cache);
+    genlComdat(gen, pub);
+
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(gen->context);
+    LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(gen->context, pub, "entry");
+    LLVMBasicBlockRef resolve = LLVMAppendBasicBlockInContext(gen->context, pub, "resolve");
+    LLVMBasicBlockRef dispatch = LLVMAppendBasicBlockInContext(gen->context, pub, "dispatch");
+
+    LLVMPositionBuilderAtEnd(builder, entry);
+    LLVMValueRef cached = LLVMBuildLoad2(builder, fnptr, cache, "cached");
+    LLVMSetOrdering(cached, LLVMAtomicOrderingMonotonic);
+    LLVMSetAlignment(cached, align);
+    LLVMBuildCondBr(builder, LLVMBuildIsNull(builder, cached, ""), resolve, dispatch);
+
+    LLVMPositionBuilderAtEnd(builder, resolve);
+    LLVMValueRef resolved = LLVMBuildCall2(builder, LLVMFunctionType(fnptr, NULL, 0, 0), resolver, NULL, 0, "resolved");
+    LLVMValueRef store = LLVMBuildStore(builder, resolved, cache);
+    LLVMSetOrdering(store, LLVMAtomicOrderingMonotonic);
+    LLVMSetAlignment(store, align);
+    LLVMBuildBr(builder, dispatch);
+
+    LLVMPositionBuilderAtEnd(builder, dispatch);
+    LLVMValueRef version = LLVMBuildPhi(builder, fnptr, "version");
+    LLVMValueRef incoming[2] = { cached, resolved };
+    LLVMBasicBlockRef fromblks[2] = { entry, resolve };
+    LLVMAddIncoming(version, incoming, fromblks, 2);
+    unsigned nparms = LLVMCountParams(pub);
+    LLVMValueRef *parms = memAllocFor(MemGenCat, (nparms? nparms : 1) * sizeof(LLVMValueRef));
+    LLVMGetParams(pub, parms);
+    LLVMValueRef call = LLVMBuildCall2(builder, fnty, version, parms, nparms, "");
+    LLVMSetTailCall(call, 1);
+    LLVMSetInstructionCallConv(call, LLVMGetFunctionCallConv(pub));
+    if (LLVMGetTypeKind(LLVMGetReturnType(fnty)) == LLVMVoidTypeKind)
+        LLVMBuildRetVoid(builder);
+    else
+        LLVMBuildRet(builder, call);
+    LLVMDisposeBuilder(builder);
+}
+
+// Generate a '@target_clones' function
+void genlFnClones(GenState *gen, FnDclNode *fnnode) {
+    LLVMValueRef pub = fnnode->llvmvar;
+
+    // A target that cannot choose gets the default version, and nothing else
+    if (!genlClonesSupported(gen->opt->triple)) {
+        if (!gen->opt->release)
+            genlSubprogram(gen, fnnode, pub);
+        genlComdat(gen, pub);
+        genlFnBody(gen, fnnode);
+        return;
+    }
+
+    size_t publen;
+    const char *pubname = LLVMGetValueName2(pub, &publen);
+    char *name = genlCloneName((char *)pubname, publen, "", "", 0);
+    LLVMTypeRef fnty = LLVMGlobalGetValueType(pub);
+
+    // Generate every version of the body. A recursive call in one calls that
+    // same version, as fnnode->llvmvar is the version while it is generated.
+    uint32_t nversions = fnnode->clones->used;
+    GenlClone *versions = memAllocFor(MemGenCat, nversions * sizeof(GenlClone));
+    for (uint32_t i = 0; i < nversions; ++i) {
+        SLitNode *spec = (SLitNode *)nodesGet(fnnode->clones, i);
+        versions[i].mask = fnCloneMask(spec->strlit, spec->strlen);
+        LLVMValueRef fn = LLVMAddFunction(gen->module, genlCloneName(name, publen, ".", spec->strlit, spec->strlen), fnty);
+        LLVMSetLinkage(fn, LLVMInternalLinkage);
+        LLVMSetFunctionCallConv(fn, LLVMGetFunctionCallConv(pub));
+        genlTargetAttrs(gen, fn, genlCloneFeatures(gen->opt->features, versions[i].mask));
+        if (!gen->opt->release)
+            genlSubprogram(gen, fnnode, fn);
+        genlComdat(gen, fn);
+        fnnode->llvmvar = fn;
+        genlFnBody(gen, fnnode);
+        versions[i].fn = fn;
+    }
+    fnnode->llvmvar = pub;
+    qsort(versions, nversions, sizeof(GenlClone), genlCloneCmp);
+
+    // The JIT that --run uses is no loader, and would call an ifunc's resolver
+    // in place of the version it returns
+    LLVMValueRef resolver = genlClonesResolver(gen, name, publen, fnty, versions, nversions);
+    if (gen->opt->run || !genlClonesIfunc(gen->opt->triple)) {
+        genlClonesStub(gen, pub, name, publen, fnty, resolver);
+        return;
+    }
+
+    // Everything that already refers to the function, a call or a vtable slot,
+    // now refers to the ifunc, which takes over its name
+    LLVMValueRef ifunc = LLVMAddGlobalIFunc(gen->module, "", 0, fnty, 0, resolver);
+    LLVMSetVisibility(ifunc, LLVMGetVisibility(pub));
+    LLVMReplaceAllUsesWith(pub, ifunc);
+    LLVMDeleteFunction(pub);
+    LLVMSetValueName2(ifunc, name, publen);
+    fnnode->llvmvar = ifunc;
+}
@@ -0,0 +1,260 @@
+/** Emitting a module's object, its assembly and its listing
+ * @file
+ *
+ * LLVM's C API runs its code generator once per file it is asked for, so
+ * asking for assembly and an object runs instruction selection and register
+ * allocation twice over the same module. --asm still does, as only the code
+ * generator writes assembly that can be assembled again. --listing instead
+ * disassembles the object already emitted into memory: it shows the very
+ * instructions the object holds, labeled with the object's symbols and
+ * annotated with what each relocation will fill in. It is a listing to read,
+ * not a source to reassemble. Where the object has no code section this
+ * recognizes, or the target no disassembler, the listing is the assembly a
+ * second run of the code generator writes.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "../coneopts.h"
+#include "../shared/error.h"
+#include "genllvm.h"
+
+#include <llvm-c/Object.h>
+#include <llvm-c/Disassembler.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// A symbol or relocation at an offset within one section
+typedef struct {
+    const char *section;    // The section's contents, which identify it if not empty
+    uint64_t offset;
+    const char *name;
+} GenlMark;
+
+static int genlMarkCmp(const void *a, const void *b) {
+    const GenlMark *ma = (const GenlMark *)a;
+    const GenlMark *mb = (const GenlMark *)b;
+    if (ma->section != mb->section)
+        return ma->section < mb->section ? -1 : 1;
+    return ma->offset < mb->offset ? -1 : ma->offset > mb->offset;
+}
+
+// Add a mark, growing the marks as needed
+static void genlAddMark(GenlMark **marks, size_t *n, size_t *avail, const char *section, uint64_t offset, const char *name) {
+    if (*n == *avail) {
+        *marks = realloc(*marks, (*avail <<= 1) * sizeof(GenlMark));
+        if (*marks == NULL)
+            errorExit(ExitMem, "Error: Out of memory");
+    }
+    (*marks)[*n].section = section;
+    (*marks)[*n].offset = offset;
+    (*marks)[(*n)++].name = name;
+}
+
+// The index of the first of the sorted marks in a section
+static size_t genlFirstMark(GenlMark *marks, size_t n, const char *section) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) >> 1;
+        if (marks[mid].section < section)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Answer whether a section holds code, by the names ELF, COFF and Mach-O give it
+static int genlIsCodeSection(const char *name) {
+    return name && (strncmp(name, ".text", 5) == 0 || strcmp(name, "__text") == 0);
+}
+
+// Write the object's code sections to lstpath as a disassembly listing.
+// Returns 0 if it could not be done this way, so that it is done another,
+// and 1 if it was done or the file could not be written (*err says so).
+// Nothing here touches the arena: a codegen unit calls this from its own thread.
+static int genlDisasm(LLVMTargetMachineRef machine, LLVMMemoryBufferRef obj, char *lstpath, char **err) {
+    char *triple = LLVMGetTargetMachineTriple(machine);
+    char *cpu = LLVMGetTargetMachineCPU(machine);
+    char *features = LLVMGetTargetMachineFeatureString(machine);
+    LLVMDisasmContextRef dc = LLVMCreateDisasmCPUFeatures(triple, cpu, features, NULL, 0, NULL, NULL);
+    LLVMDisposeMessage(triple);
+    LLVMDisposeMessage(cpu);
+    LLVMDisposeMessage(features);
+    if (dc == NULL)
+        return 0;
+
+    char *binerr = NULL;
+    LLVMBinaryRef bin = LLVMCreateBinary(obj, NULL, &binerr);
+    if (bin == NULL) {
+        LLVMDisposeMessage(binerr);
+        LLVMDisasmDispose(dc);
+        return 0;
+    }
+
+    // Gather every named symbol in a code section, and every relocation that
+    // applies to one, sorted by section and offset. Each section's are then
+    // merged into its listing as it is disassembled.
+    size_t nsyms = 0, availsyms = 256;
+    GenlMark *syms = malloc(availsyms * sizeof(GenlMark));
+    if (syms == NULL)
+        errorExit(ExitMem, "Error: Out of memory");
+    LLVMSectionIteratorRef sect = LLVMObjectFileCopySectionIterator(bin);
+    LLVMSymbolIteratorRef sym = LLVMObjectFileCopySymbolIterator(bin);
+    for (; !LLVMObjectFileIsSymbolIteratorAtEnd(bin, sym); LLVMMoveToNextSymbol(sym)) {
+        const char *name = LLVMGetSymbolName(sym);
+        if (name == NULL || *name == '\0')
+            continue;
+        // ELF names a section's own symbol for the section, which labels nothing
+        LLVMMoveToContainingSection(sect, sym);
+        if (LLVMObjectFileIsSectionIteratorAtEnd(bin, sect) || !genlIsCodeSection(LLVMGetSectionName(sect))
+            || strcmp(name, LLVMGetSectionName(sect)) == 0 || LLVMGetSectionSize(sect) == 0)
+            continue;
+        genlAddMark(&syms, &nsyms, &availsyms, LLVMGetSectionContents(sect),
+            LLVMGetSymbolAddress(sym) - LLVMGetSectionAddress(sect), name);
+    }
+    LLVMDisposeSymbolIterator(sym);
+    LLVMDisposeSectionIterator(sect);
+    qsort(syms, nsyms, sizeof(GenlMark), genlMarkCmp);
+
+    // COFF and Mach-O keep a section's relocations with it. ELF keeps them in
+    // a section of their own, named for the one they apply to, and the C API
+    // has no way to ask which that is, so it is found by name.
+    size_t nrelocs = 0, availrelocs = 256;
+    GenlMark *relocs = malloc(availrelocs * sizeof(GenlMark));
+    if (relocs == NULL)
+        errorExit(ExitMem, "Error: Out of memory");
+    sect = LLVMObjectFileCopySectionIterator(bin);
+    LLVMSectionIteratorRef target = LLVMObjectFileCopySectionIterator(bin);
+    const char *lastcode = NULL;
+    const char *lastcontents = NULL;
+    for (; !LLVMObjectFileIsSectionIteratorAtEnd(bin, sect); LLVMMoveToNextSection(sect)) {
+        const char *name = LLVMGetSectionName(sect);
+        const char *applies = NULL;
+        if (genlIsCodeSection(name) && LLVMGetSectionSize(sect) > 0) {
+            applies = lastcontents = LLVMGetSectionContents(sect);
+            lastcode = name;
+        }
+        else if (name && strncmp(name, ".rel", 4) == 0) {
+            const char *targetname = name + (strncmp(name, ".rela", 5) == 0 ? 5 : 4);
+            if (!genlIsCodeSection(targetname))
+                continue;
+            // LLVM writes each right after the section it applies to, so that
+            // one is tried before all of them are
+            if (lastcode && strcmp(lastcode, targetname) == 0)
+                applies = lastcontents;
+            else {
+                LLVMDisposeSectionIterator(target);
+                target = LLVMObjectFileCopySectionIterator(bin);
+                // ELF's first section is nameless, and LLVM names it NULL
+                while (!LLVMObjectFileIsSectionIteratorAtEnd(bin, target)
+                    && (LLVMGetSectionName(target) == NULL || strcmp(LLVMGetSectionName(target), targetname) != 0))
+                    LLVMMoveToNextSection(target);
+                if (!LLVMObjectFileIsSectionIteratorAtEnd(bin, target) && LLVMGetSectionSize(target) > 0)
+                    applies = LLVMGetSectionContents(target);
+            }
+        }
+        if (applies == NULL)
+            continue;
+        LLVMRelocationIteratorRef reloc = LLVMGetRelocations(sect);
+        for (; !LLVMIsRelocationIteratorAtEnd(sect, reloc); LLVMMoveToNextRelocation(reloc)) {
+            // A relocation against no symbol is given the end of the symbols
+            LLVMSymbolIteratorRef relsym = LLVMGetRelocationSymbol(reloc);
+            const char *symname = LLVMObjectFileIsSymbolIteratorAtEnd(bin, relsym) ? NULL : LLVMGetSymbolName(relsym);
+            if (symname && *symname)
+                genlAddMark(&relocs, &nrelocs, &availrelocs, applies, LLVMGetRelocationOffset(reloc), symname);
+            LLVMDisposeSymbolIterator(relsym);
+        }
+        LLVMDisposeRelocationIterator(reloc);
+    }
+    LLVMDisposeSectionIterator(target);
+    LLVMDisposeSectionIterator(sect);
+    qsort(relocs, nrelocs, sizeof(GenlMark), genlMarkCmp);
+
+    int listed = 0;
+    FILE *out = fopen(lstpath, "w");
+    if (out == NULL)
+        *err = LLVMCreateMessage(lstpath);
+    sect = LLVMObjectFileCopySectionIterator(bin);
+    for (; out && !LLVMObjectFileIsSectionIteratorAtEnd(bin, sect); LLVMMoveToNextSection(sect)) {
+        const char *sectname = LLVMGetSectionName(sect);
+        const char *contents = LLVMGetSectionContents(sect);
+        uint8_t *code = (uint8_t *)contents;
+        uint64_t size = LLVMGetSectionSize(sect);
+        if (!genlIsCodeSection(sectname) || size == 0)
+            continue;
+        listed = 1;
+        fprintf(out, "\n\t.section\t%s\n", sectname);
+
+        size_t symat = genlFirstMark(syms, nsyms, contents);
+        size_t relat = genlFirstMark(relocs, nrelocs, contents);
+        uint64_t offset = 0;
+        char inst[256];
+        while (offset < size) {
+            for (; symat < nsyms && syms[symat].section == contents && syms[symat].offset <= offset; ++symat) {
+                if (syms[symat].offset == offset)
+                    fprintf(out, "%s:\n", syms[symat].name);
+            }
+            size_t len = LLVMDisasmInstruction(dc, code + offset, size - offset, offset, inst, sizeof(inst));
+            if (len == 0) {
+                fprintf(out, "\t.byte\t0x%02x", code[offset]);
+                len = 1;
+            }
+            else
+                fprintf(out, "%s", inst);
+            // Name what each relocation within the instruction will fill in
+            char *sep = "\t\t# ";
+            for (; relat < nrelocs && relocs[relat].section == contents && relocs[relat].offset < offset + len; ++relat) {
+                fprintf(out, "%s%s", sep, relocs[relat].name);
+                sep = ", ";
+            }
+            fputc('\n', out);
+            offset += len;
+        }
+    }
+    LLVMDisposeSectionIterator(sect);
+    if (out)
+        fclose(out);
+    free(relocs);
+    free(syms);
+    LLVMDisposeBinary(bin);
+    LLVMDisasmDispose(dc);
+    return listed || out == NULL;
+}
+
+// Emit a module's object to objpath, its assembly to asmpath if that is not
+// NULL, and its listing to lstpath if that is not NULL. Only the assembly takes
+// a second run of the code generator. Returns NULL, or which of them failed,
+// with why in *errmsg (dispose with LLVMDisposeMessage). It neither reports
+// errors nor touches the arena, so a codegen unit may call it from its own thread.
+char *genlEmit(LLVMTargetMachineRef machine, LLVMModuleRef mod, char *objpath, char *asmpath, char *lstpath, char **errmsg) {
+    LLVMMemoryBufferRef obj;
+    if (LLVMTargetMachineEmitToMemoryBuffer(machine, mod, LLVMObjectFile, errmsg, &obj) != 0)
+        return "emit obj file";
+
+    size_t size = LLVMGetBufferSize(obj);
+    FILE *out = fopen(objpath, "wb");
+    int written = out && fwrite(LLVMGetBufferStart(obj), 1, size, out) == size;
+    if (out && fclose(out) != 0)
+        written = 0;
+    if (!written) {
+        LLVMDisposeMemoryBuffer(obj);
+        *errmsg = LLVMCreateMessage(objpath);
+        return "write obj file";
+    }
+
+    char *failed = NULL;
+    *errmsg = NULL;
+    if (lstpath && !genlDisasm(machine, obj, lstpath, errmsg)
+        && LLVMTargetMachineEmitToFile(machine, mod, lstpath, LLVMAssemblyFile, errmsg) != 0)
+        failed = "emit listing file";
+    if (*errmsg && !failed)
+        failed = "emit listing file";
+    LLVMDisposeMemoryBuffer(obj);
+    if (!failed && asmpath && LLVMTargetMachineEmitToFile(machine, mod, asmpath, LLVMAssemblyFile, errmsg) != 0)
+        failed = "emit asm file";
+    return failed;
+}
@@ -41,8 +41,8 @@ LLVMValueRef genlIf(GenState *gen, IfNode *ifnode) {
     count = ifnode->condblk->used / 2;
     i = phicnt = 0;
     if (vtype != unknownType) {
-        blkvals = memAllocBlk(count * sizeof(LLVMValueRef));
-        blks = memAllocBlk(count * sizeof(LLVMBasicBlockRef));
+        blkvals = memAllocFor(MemGenCat, count * sizeof(LLVMValueRef));
+        blks = memAllocFor(MemGenCat, count * sizeof(LLVMBasicBlockRef));
     }
 
     endif = genlInsertBlock(gen, "endif");
@@ -145,9 +145,7 @@ LLVMValueRef genlFnCallInternal(GenState *gen, int dispatch, INode *objfn, uint3
             for (nodesFor(fnsig->parms, cnt, nodesp)) {
                 VarDclNode* var = (VarDclNode*)*nodesp;
                 assert(var->tag == VarDclTag);
-                // We always alloca in case variable is mutable or we want to take address of its value
-                var->llvmvar = genlAlloca(gen, genlType(gen, var->vtype), &var->namesym->namestr);
-                LLVMBuildStore(gen->builder, *fnargs++, var->llvmvar);
+                genlVarBind(gen, var, *fnargs++);
             }
         }
 
@@ -404,7 +402,7 @@ LLVMValueRef genlFnCall(GenState *gen, FnCallNode *fncall) {
 
     // Get count and Valuerefs for all the arguments to pass to the function
     uint32_t fnargcnt = fncall->args->used;
-    LLVMValueRef *fnargs = (LLVMValueRef*)memAllocBlk(fnargcnt * sizeof(LLVMValueRef*));
+    LLVMValueRef *fnargs = (LLVMValueRef*)memAllocFor(MemGenCat, fnargcnt * sizeof(LLVMValueRef*));
     LLVMValueRef *fnarg = fnargs;
     INode **nodesp;
     uint32_t cnt;
@@ -669,12 +667,12 @@ LLVMValueRef genlLogic(GenState *gen, LogicNode* node) {
 // Generate local variable
 LLVMValueRef genlLocalVar(GenState *gen, VarDclNode *var) {
     assert(var->tag == VarDclTag);
-    LLVMValueRef val = NULL;
-    var->llvmvar = genlAlloca(gen, genlType(gen, var->vtype), &var->namesym->namestr);
-    if (var->value) {
-        val = genlExpr(gen, var->value);
-        LLVMBuildStore(gen->builder, val, var->llvmvar);
+    if (var->value == NULL) {
+        var->llvmvar = genlAlloca(gen, genlType(gen, var->vtype), &var->namesym->namestr);
+        return NULL;
     }
+    LLVMValueRef val = genlExpr(gen, var->value);
+    genlVarBind(gen, var, val);
     return val;
 }
 
@@ -791,7 +789,7 @@ LLVMValueRef genlArrayIndex(GenState *gen, FnCallNode *fncall, ArrayNode *objtyp
     LLVMValueRef *indexp = &indexes[0];
     uint16_t nindex = objtype->dimens->used;
     if (nindex > 1)
-        indexp = memAllocBlk(nindex * sizeof(LLVMValueRef));
+        indexp = memAllocFor(MemGenCat, nindex * sizeof(LLVMValueRef));
     indexp[0] = LLVMConstInt(genlUsize(gen), 0, 0);
     
     // Populate indexing buffer
@@ -828,7 +826,15 @@ LLVMValueRef genlAddr(GenState *gen, INode *lval) {
         INode *dclnode = ((NameUseNode *)lval)->dclnode;
         if (dclnode->tag == FnDclTag)
             return ((FnDclNode*)dclnode)->llvmvar;
-        return ((VarDclNode*)dclnode)->llvmvar;
+        VarDclNode *var = (VarDclNode*)dclnode;
+        if (genlVarIsValue(var)) {
+            // Type check marks every way of reaching a variable's address, so
+            // this is not expected; a copy of the value still reads correctly
+            LLVMValueRef copy = genlAlloca(gen, LLVMTypeOf(var->llvmvar), &var->namesym->namestr);
+            LLVMBuildStore(gen->builder, var->llvmvar, copy);
+            return copy;
+        }
+        return var->llvmvar;
     }
     case DerefTag:
         return genlExpr(gen, ((StarNode *)lval)->vtexp);
@@ -955,8 +961,10 @@ void genlStore(GenState *gen, INode *lval, LLVMValueRef rval) {
 // Generate a term
 LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
     if (!gen->opt->release && gen->fn) {
+        SrcPos pos;
+        srclocDecode(termnode->srcloc, &pos);
         LLVMMetadataRef loc = LLVMDIBuilderCreateDebugLocation(gen->context, 
-            termnode->linenbr, (unsigned)(termnode->srcp-termnode->linep), LLVMGetSubprogram(gen->fn), NULL);
+            pos.linenbr, (unsigned)(pos.tokp-pos.linep), LLVMGetSubprogram(gen->fn), NULL);
         LLVMValueRef val = LLVMMetadataAsValue(gen->context, loc);
         LLVMSetCurrentDebugLocation(gen->builder, val);
     }
@@ -979,7 +987,7 @@ LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
             assert(dimnode->tag == ULitTag);
             size = (uint32_t)((ULitNode*)dimnode)->uintlit;
         }
-        LLVMValueRef *values = (LLVMValueRef *)memAllocBlk(size * sizeof(LLVMValueRef *));
+        LLVMValueRef *values = (LLVMValueRef *)memAllocFor(MemGenCat, size * sizeof(LLVMValueRef *));
         LLVMValueRef *valuep = values;
         if (lit->dimens->used > 0) {
             LLVMValueRef fillval = genlExpr(gen, nodesGet(lit->elems, 0));
@@ -1064,7 +1072,8 @@ LLVMValueRef genlExpr(GenState *gen, INode *termnode) {
     {
         VarDclNode *vardcl = (VarDclNode*)((NameUseNode *)termnode)->dclnode;
         if (vardcl->tag == VarDclTag)
-            return LLVMBuildLoad(gen->builder, vardcl->llvmvar, &vardcl->namesym->namestr);
+            return genlVarIsValue(vardcl) ? vardcl->llvmvar
+                : LLVMBuildLoad(gen->builder, vardcl->llvmvar, &vardcl->namesym->namestr);
         else if (vardcl->tag == ConstDclTag) {
             ConstDclNode *constdcl = (ConstDclNode*)vardcl;
             return genlExpr(gen, constdcl->value);
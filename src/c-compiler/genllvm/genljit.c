@@ -0,0 +1,132 @@
+/** In-process execution, for --run
+ * @file
+ *
+ * With --run, conec is the program's loader as well as its compiler. ORC's
+ * LLJIT compiles the optimized module into conec's own memory and conec calls
+ * its main, so running a program costs no object file, no link and no process.
+ *
+ * A program calls into conestd, and conec is linked with conestd so that the
+ * program can call conec's copy. Everything else a program names -- the C
+ * library, mostly -- is looked up among what the process has already loaded.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "../ir/ir.h"
+#include "../shared/error.h"
+#include "../shared/memory.h"
+#include "../coneopts.h"
+#include "genllvm.h"
+
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Orc.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// conestd's functions, as src/conestd defines them. Naming them here is what
+// links them into conec, and it is their addresses here that a program's
+// calls resolve to, whether or not the executable exports its symbols.
+// A function added to conestd belongs in genlJitStd too.
+void printStr(char *p, size_t len);
+void printCStr(char *p);
+void printInt(int64_t nbr);
+void printUInt(uint64_t nbr);
+void printFloat(double nbr);
+void printChar(uint64_t code);
+uint64_t coneCpuFeatures();
+
+typedef struct {
+    char *name;
+    void (*fn)();
+} GenlJitSym;
+
+static GenlJitSym genlJitStd[] = {
+    {"printStr", (void (*)())printStr},
+    {"printCStr", (void (*)())printCStr},
+    {"printInt", (void (*)())printInt},
+    {"printUInt", (void (*)())printUInt},
+    {"printFloat", (void (*)())printFloat},
+    {"printChar", (void (*)())printChar},
+    {"coneCpuFeatures", (void (*)())coneCpuFeatures},
+    {NULL, NULL}
+};
+
+// Report an ORC error, if there is one, and consume it
+static int genlJitFailed(LLVMErrorRef err, char *what) {
+    if (err == NULL)
+        return 0;
+    char *msg = LLVMGetErrorMessage(err);
+    errorMsg(ErrorGenErr, "%s: %s", what, msg);
+    LLVMDisposeErrorMessage(msg);
+    return 1;
+}
+
+// Define conestd's functions in the JIT's main library, at conec's copies
+static LLVMErrorRef genlJitDefineStd(LLVMOrcLLJITRef jit, LLVMOrcJITDylibRef dylib) {
+    size_t nsyms = 0;
+    while (genlJitStd[nsyms].name)
+        ++nsyms;
+    LLVMJITCSymbolMapPair *syms = memAllocFor(MemGenCat, nsyms * sizeof(LLVMJITCSymbolMapPair));
+    for (size_t i = 0; i < nsyms; ++i) {
+        syms[i].Name = LLVMOrcLLJITMangleAndIntern(jit, genlJitStd[i].name);
+        syms[i].Sym.Address = (LLVMOrcJITTargetAddress)(uintptr_t)genlJitStd[i].fn;
+        syms[i].Sym.Flags.GenericFlags = LLVMJITSymbolGenericFlagsExported | LLVMJITSymbolGenericFlagsCallable;
+        syms[i].Sym.Flags.TargetFlags = 0;
+    }
+    return LLVMOrcJITDylibDefine(dylib, LLVMOrcAbsoluteSymbols(syms, nsyms));
+}
+
+// Compile the optimized module into this process, for --run, and find its main.
+// The lookup is what compiles it, so any failure is reported with the compile's.
+void genlJit(GenState *gen) {
+    // The JIT's target machine is made as the build's is, so --cpu, --features
+    // and --opt mean the same for a program that is run as for one that is built
+    LLVMOrcLLJITBuilderRef builder = LLVMOrcCreateLLJITBuilder();
+    LLVMTargetMachineRef machine = genlNewMachine(LLVMGetTargetMachineTarget(gen->machine), gen->opt);
+    LLVMOrcLLJITBuilderSetJITTargetMachineBuilder(builder,
+        LLVMOrcJITTargetMachineBuilderCreateFromTargetMachine(machine));
+    if (genlJitFailed(LLVMOrcCreateLLJIT(&gen->jit, builder), "Could not create the JIT"))
+        return;
+
+    LLVMOrcJITDylibRef dylib = LLVMOrcLLJITGetMainJITDylib(gen->jit);
+    if (genlJitFailed(genlJitDefineStd(gen->jit, dylib), "Could not define conestd to the JIT"))
+        return;
+    LLVMOrcDefinitionGeneratorRef process;
+    if (genlJitFailed(LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(&process,
+        LLVMOrcLLJITGetGlobalPrefix(gen->jit), NULL, NULL), "Could not search this process for symbols"))
+        return;
+    LLVMOrcJITDylibAddGenerator(dylib, process);
+
+    // The JIT owns what it compiles, context and all, and the module is in the
+    // global context. So it is moved by way of bitcode, as a codegen unit's is.
+    LLVMMemoryBufferRef bitcode = LLVMWriteBitcodeToMemoryBuffer(gen->module);
+    LLVMOrcThreadSafeContextRef tsctx = LLVMOrcCreateNewThreadSafeContext();
+    LLVMModuleRef mod;
+    int unread = LLVMParseBitcodeInContext2(LLVMOrcThreadSafeContextGetContext(tsctx), bitcode, &mod);
+    LLVMDisposeMemoryBuffer(bitcode);
+    if (unread) {
+        LLVMOrcDisposeThreadSafeContext(tsctx);
+        errorMsg(ErrorGenErr, "Could not read back the module for the JIT");
+        return;
+    }
+    LLVMOrcThreadSafeModuleRef tsmod = LLVMOrcCreateNewThreadSafeModule(mod, tsctx);
+    LLVMOrcDisposeThreadSafeContext(tsctx);   // The module holds its own reference
+    if (genlJitFailed(LLVMOrcLLJITAddLLVMIRModule(gen->jit, dylib, tsmod), "Could not add the program to the JIT"))
+        return;
+
+    if (genlJitFailed(LLVMOrcLLJITLookup(gen->jit, &gen->jitmain, "main"), "Could not compile the program to run it"))
+        return;
+}
+
+// Call the program's main with these arguments, and return its exit status.
+// main gets them as C's would; one declared with no parameters ignores them.
+int genlJitRun(GenState *gen, int argc, char **argv) {
+    int (*mainfn)(int, char **) = (int (*)(int, char **))(uintptr_t)gen->jitmain;
+    int status = mainfn(argc, argv);
+    LLVMOrcDisposeLLJIT(gen->jit);
+    return status;
+}
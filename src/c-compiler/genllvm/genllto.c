@@ -0,0 +1,159 @@
+/** Link-time optimization: optimizing bitcode modules as one program
+ * @file
+ *
+ * Each compile optimizes its own module, so a call into another module (or
+ * into conestd) is a call the optimizer can see nothing behind: it cannot be
+ * inlined, and what only it would have called cannot be dropped. With
+ * --emit=bc each compile writes its module as bitcode instead of an object,
+ * optimized only as far as LLVM's pre-link pipeline goes. --lto then links
+ * those modules into one, with conestd's bitcode too for --runtimebc, and makes
+ * every definition local to it except the ones it is entered by. LLVM's
+ * link-time pipeline can then inline across what were module boundaries and
+ * drop whatever is no longer called, before one object is emitted for it all.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "../ir/ir.h"
+#include "../shared/error.h"
+#include "../shared/timer.h"
+#include "../shared/fileio.h"
+#include "../coneopts.h"
+#include "genllvm.h"
+
+#include <llvm-c/BitReader.h>
+#include <llvm-c/Comdat.h>
+#include <llvm-c/Linker.h>
+
+#include <stdio.h>
+#include <string.h>
+
+// Report what LLVM says is wrong with a module it is reading or linking.
+// Left to itself, LLVM would print it and exit.
+static void genlLtoDiagnose(LLVMDiagnosticInfoRef info, void *path) {
+    if (LLVMGetDiagInfoSeverity(info) != LLVMDSError)
+        return;
+    char *desc = LLVMGetDiagInfoDescription(info);
+    errorMsg(ErrorGenErr, "%s: %s", *(char **)path, desc);
+    LLVMDisposeMessage(desc);
+}
+
+// Read a bitcode file into a module, or answer NULL if it is not one
+static LLVMModuleRef genlLtoRead(GenState *gen, char *path) {
+    LLVMMemoryBufferRef buf;
+    char *err;
+    if (LLVMCreateMemoryBufferWithContentsOfFile(path, &buf, &err) != 0)
+        errorExit(ExitNF, "Cannot read %s: %s", path, err);
+
+    // Bitcode starts "BC" 0xC0DE, or with the wrapper's 0x0B17C0DE
+    const unsigned char *magic = (const unsigned char *)LLVMGetBufferStart(buf);
+    size_t size = LLVMGetBufferSize(buf);
+    LLVMModuleRef mod = NULL;
+    if (size >= 4 && ((magic[0] == 'B' && magic[1] == 'C' && magic[2] == 0xC0 && magic[3] == 0xDE)
+        || (magic[0] == 0xDE && magic[1] == 0xC0 && magic[2] == 0x17 && magic[3] == 0x0B))) {
+        if (LLVMParseBitcodeInContext2(gen->context, buf, &mod) != 0)
+            mod = NULL;
+    }
+    else
+        errorMsg(ErrorGenErr, "%s is not LLVM bitcode. Write it with --emit=bc.", path);
+    LLVMDisposeMemoryBuffer(buf);
+    return mod;
+}
+
+// Make a definition local to the program, unless it is one the program is
+// entered by: main, or with --library, any public function
+static void genlLtoLocal(LLVMValueRef global, int library) {
+    if (LLVMIsDeclaration(global))
+        return;
+    LLVMLinkage linkage = LLVMGetLinkage(global);
+    if (linkage == LLVMInternalLinkage || linkage == LLVMPrivateLinkage
+        || linkage == LLVMAppendingLinkage || linkage == LLVMAvailableExternallyLinkage)
+        return;
+    size_t len;
+    const char *name = LLVMGetValueName2(global, &len);
+    if (strncmp(name, "llvm.", 5) == 0)
+        return;
+    if (library? linkage == LLVMExternalLinkage && LLVMGetVisibility(global) == LLVMDefaultVisibility
+        : strcmp(name, "main") == 0)
+        return;
+
+    LLVMSetLinkage(global, LLVMInternalLinkage);
+    LLVMSetVisibility(global, LLVMDefaultVisibility);
+    LLVMSetDLLStorageClass(global, LLVMDefaultStorageClass);
+    if (LLVMGetComdat(global))
+        LLVMSetComdat(global, NULL);
+}
+
+// Link bitcode files into one module, optimize it as a whole program, and emit it
+void genlLto(GenState *gen, char **paths, int npaths) {
+    ConeOptions *opt = gen->opt;
+    char *err;
+
+    // Every module is linked into the first
+    timerBegin(LoadTimer);
+    if (timerTracing)
+        timerTraceBegin("LinkBitcode", NULL);
+    char *path = NULL;
+    LLVMContextSetDiagnosticHandler(gen->context, genlLtoDiagnose, &path);
+    LLVMModuleRef mod = NULL;
+    for (int i = 0; i < npaths; ++i) {
+        path = paths[i];
+        LLVMModuleRef linked = genlLtoRead(gen, path);
+        if (linked == NULL)
+            continue;
+        if (mod == NULL)
+            mod = linked;
+        else if (LLVMLinkModules2(mod, linked) != 0 && errors == 0)
+            errorMsg(ErrorGenErr, "Could not link %s", path);
+    }
+    LLVMContextSetDiagnosticHandler(gen->context, NULL, NULL);
+    if (timerTracing)
+        timerTraceEnd();
+    if (mod == NULL || errors) {
+        if (mod)
+            LLVMDisposeModule(mod);
+        return;
+    }
+
+    // Each file carries the target it was written for, but the runtime's need
+    // not spell it as this compile does, and the pipeline is about to run
+    genlSetTarget(gen, mod);
+
+    LLVMValueRef global;
+    for (global = LLVMGetFirstFunction(mod); global; global = LLVMGetNextFunction(global))
+        genlLtoLocal(global, opt->library);
+    for (global = LLVMGetFirstGlobal(mod); global; global = LLVMGetNextGlobal(global))
+        genlLtoLocal(global, opt->library);
+
+    // The link-time pipeline: inlining across what were modules, and dropping
+    // what is left with no caller, among the rest
+    timerBegin(OptTimer);
+    if (timerTracing)
+        timerTraceBegin("Optimize", NULL);
+    char *opterr = genlOptimize(opt, mod, gen->machine);
+    if (timerTracing)
+        timerTraceEnd();
+    if (opterr) {
+        errorMsg(ErrorGenErr, "Could not optimize: %s", opterr);
+        LLVMDisposeMessage(opterr);
+        LLVMDisposeModule(mod);
+        return;
+    }
+
+    if (opt->print_llvmir && LLVMPrintModuleToFile(mod, fileMakePath(opt->output, opt->srcname, "ir"), &err) != 0) {
+        errorMsg(ErrorGenErr, "Could not emit ir file: %s", err);
+        LLVMDisposeMessage(err);
+    }
+
+    timerBegin(CodeGenTimer);
+    if (timerTracing)
+        timerTraceBegin("Codegen", NULL);
+    genlOut(genlObjPath(opt),
+        opt->print_asm? genlAsmPath(opt) : NULL,
+        opt->print_listing? genlLstPath(opt) : NULL,
+        mod, gen->machine);
+    if (timerTracing)
+        timerTraceEnd();
+    LLVMDisposeModule(mod);
+}
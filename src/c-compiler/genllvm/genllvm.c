@@ -19,13 +19,14 @@
 #include <llvm-c/Analysis.h>
 #include <llvm-c/BitWriter.h>
 #include <llvm-c/Comdat.h>
+#include <llvm-c/Transforms/PassBuilder.h>
 #include <llvm-c/Transforms/Scalar.h>
-#include <llvm-c/Transforms/IPO.h>
-#if LLVM_VERSION_MAJOR >= 7
-#include "llvm-c/Transforms/Utils.h"
-#endif
+#include <llvm-c/Transforms/InstCombine.h>
+#include <llvm-c/Transforms/Utils.h>
+#include <llvm-c/Support.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 
@@ -37,12 +38,35 @@
 #define objext "o"
 #endif
 
+// Answer whether a local variable or parameter is its value, rather than storage
+// holding it. It is when it may not be written, type check and flow found
+// nothing that assigns it after its declaration or takes its address, and it
+// is not an array, which is indexed in place.
+int genlVarIsValue(VarDclNode *var) {
+    if (var->scope == 0 || (var->flowflags & (VarAddressed | VarAssigned)))
+        return 0;
+    if (var->perm->tag != TypeNameUseTag && var->perm->tag != PermTag)
+        return 0;
+    return !(permGetFlags(var->perm) & MayWrite) && iexpGetTypeDcl((INode*)var)->tag != ArrayTag;
+}
+
+// Bind a local variable or parameter to its initial value: as that value, if
+// it needs no storage, and otherwise stored into storage made for it
+void genlVarBind(GenState *gen, VarDclNode *var, LLVMValueRef val) {
+    if (genlVarIsValue(var)) {
+        var->llvmvar = val;
+        if (LLVMIsAInstruction(val) && *LLVMGetValueName(val) == '\0')
+            LLVMSetValueName2(val, &var->namesym->namestr, var->namesym->namesz);
+        return;
+    }
+    var->llvmvar = genlAlloca(gen, genlType(gen, var->vtype), &var->namesym->namestr);
+    LLVMBuildStore(gen->builder, val, var->llvmvar);
+}
+
 // Generate parameter variable
 void genlParmVar(GenState *gen, VarDclNode *var) {
     assert(var->tag == VarDclTag);
-    // We always alloca in case variable is mutable or we want to take address of its value
-    var->llvmvar = genlAlloca(gen, genlType(gen, var->vtype), &var->namesym->namestr);
-    LLVMBuildStore(gen->builder, LLVMGetParam(gen->fn, var->index), var->llvmvar);
+    genlVarBind(gen, var, LLVMGetParam(gen->fn, var->index));
 }
 
 // Put a generated global in a COMDAT of its own, named for the symbol itself.
@@ -90,17 +114,8 @@ static void genlNameAnonFn(GenState *gen, LLVMValueRef fn) {
     LLVMSetLinkage(fn, LLVMInternalLinkage);
 }
 
-// Generate a function
-void genlFn(GenState *gen, FnDclNode *fnnode) {
-    // Only a concrete declaration has an implementation. An overload name is a
-    // namespace binding that selection replaces long before generation.
-    assert(fnnode->tag == FnDclTag && "Only a concrete function/method is generated");
-    if ((fnnode->flags & FlagInline) || fnnode->value->tag == IntrinsicTag)
-        return;
-
-    genlNameAnonFn(gen, fnnode->llvmvar);
-    genlComdat(gen, fnnode->llvmvar);
-
+// Generate a function's body into its LLVM function, fnnode->llvmvar
+void genlFnBody(GenState *gen, FnDclNode *fnnode) {
     LLVMValueRef svfn = gen->fn;
     LLVMBuilderRef svbuilder = gen->builder;
     LLVMValueRef svallocaPoint = gen->allocaPoint;
@@ -136,20 +151,51 @@ void genlFn(GenState *gen, FnDclNode *fnnode) {
 
     LLVMDisposeBuilder(gen->builder);
 
+    // Clean up the function while it is still small and in cache. A function
+    // --verify would reject is left for it to report, not handed to the passes.
+    if (gen->fnpasses && !(gen->opt->verify && LLVMVerifyFunction(gen->fn, LLVMReturnStatusAction)))
+        LLVMRunFunctionPassManager(gen->fnpasses, gen->fn);
+
     gen->builder = svbuilder;
     gen->fn = svfn;
     gen->allocaPoint = svallocaPoint;
     gen->fnblock = svfnblock;
 }
 
+// Generate a function
+void genlFn(GenState *gen, FnDclNode *fnnode) {
+    // Only a concrete declaration has an implementation. An overload name is a
+    // namespace binding that selection replaces long before generation.
+    assert(fnnode->tag == FnDclTag && "Only a concrete function/method is generated");
+    if ((fnnode->flags & FlagInline) || fnnode->value->tag == IntrinsicTag)
+        return;
+
+    genlNameAnonFn(gen, fnnode->llvmvar);
+    if (timerTracing)
+        timerTraceBegin("GenFunction", (char *)LLVMGetValueName(fnnode->llvmvar));
+    if (fnnode->clones)
+        genlFnClones(gen, fnnode);
+    else {
+        genlComdat(gen, fnnode->llvmvar);
+        genlFnBody(gen, fnnode);
+    }
+    if (timerTracing)
+        timerTraceEnd();
+}
+
 // Insert every alloca before the allocaPoint in the function's entry block.
 // Why? To improve LLVM optimization of SRoA and mem2reg, all allocas
 // should be located in the function's entry block before the first call.
+// Positioning before allocaPoint also takes on its (empty) debug location,
+// so the current one is put back afterwards: a call left without one
+// fails the verifier when a debug module is reloaded from bitcode.
 LLVMValueRef genlAlloca(GenState *gen, LLVMTypeRef type, const char *name) {
     LLVMBasicBlockRef current_block = LLVMGetInsertBlock(gen->builder);
+    LLVMMetadataRef debugloc = LLVMGetCurrentDebugLocation2(gen->builder);
     LLVMPositionBuilderBefore(gen->builder, gen->allocaPoint);
     LLVMValueRef alloca = LLVMBuildAlloca(gen->builder, type, name);
     LLVMPositionBuilderAtEnd(gen->builder, current_block);
+    LLVMSetCurrentDebugLocation2(gen->builder, debugloc);
     return alloca;
 }
 
@@ -199,7 +245,7 @@ void genlGloVarName(GenState *gen, VarDclNode *glovar) {
 // A concrete function/method needs no signature mangling: its source name is
 // unique in its namespace, and its generated name already carries that namespace.
 char *genlMangleMethName(char *workbuf, FnDclNode *node) {
-    if (node->instnode == NULL)
+    if (inodeGetInstnode((INode *)node) == NULL)
         return node->genname;
 
     strcat(workbuf, node->genname);
@@ -217,6 +263,32 @@ char *genlMangleMethName(char *workbuf, FnDclNode *node) {
     return workbuf;
 }
 
+// Attach debug info describing a function declaration to the LLVM function
+// generated for it (debug mode only)
+void genlSubprogram(GenState *gen, FnDclNode *glofn, LLVMValueRef fn) {
+    char *fnname = glofn->namesym? &glofn->namesym->namestr : "";
+    size_t linknmlen;
+    const char *linknm = LLVMGetValueName2(fn, &linknmlen);
+    LLVMMetadataRef fntype = LLVMDIBuilderCreateSubroutineType(gen->dibuilder,
+        gen->difile, NULL, 0, 0);
+    SrcPos pos;
+    srclocDecode(glofn->srcloc, &pos);
+    LLVMMetadataRef sp = LLVMDIBuilderCreateFunction(gen->dibuilder, gen->difile,
+        fnname, strlen(fnname), linknm, linknmlen,
+        gen->difile, pos.linenbr, fntype, 0, 1, pos.linenbr, LLVMDIFlagPublic, 0);
+    LLVMSetSubprogram(fn, sp);
+}
+
+// Mark a function definition with the target CPU genlCreateMachine chose, and features
+void genlTargetAttrs(GenState *gen, LLVMValueRef fn, char *features) {
+    char *cpu = gen->opt->cpu;
+    LLVMAddAttributeAtIndex(fn, LLVMAttributeFunctionIndex,
+        LLVMCreateStringAttribute(gen->context, "target-cpu", 10, cpu, strlen(cpu)));
+    if (*features)
+        LLVMAddAttributeAtIndex(fn, LLVMAttributeFunctionIndex,
+            LLVMCreateStringAttribute(gen->context, "target-features", 15, features, strlen(features)));
+}
+
 // Generate LLVMValueRef for a global function
 void genlGloFnName(GenState *gen, FnDclNode *glofn) {
     // Do not generate inline functions
@@ -248,15 +320,15 @@ void genlGloFnName(GenState *gen, FnDclNode *glofn) {
             LLVMSetVisibility(glofn->llvmvar, LLVMHiddenVisibility);
         }
 
-        // Add metadata on implemented functions (debug mode only)
-        if (!gen->opt->release && glofn->value) {
-            LLVMMetadataRef fntype = LLVMDIBuilderCreateSubroutineType(gen->dibuilder,
-                gen->difile, NULL, 0, 0);
-            LLVMMetadataRef sp = LLVMDIBuilderCreateFunction(gen->dibuilder, gen->difile,
-                fnname, strlen(fnname), manglednm, strlen(manglednm),
-                gen->difile, glofn->linenbr, fntype, 0, 1, glofn->linenbr, LLVMDIFlagPublic, 0);
-            LLVMSetSubprogram(glofn->llvmvar, sp);
-        }
+        // Add metadata on implemented functions (debug mode only).
+        // Each version of a multiversioned function gets its own instead.
+        if (!gen->opt->release && glofn->value && !glofn->clones)
+            genlSubprogram(gen, glofn, glofn->llvmvar);
+
+        // Record the CPU and features the body is generated for, as clang does,
+        // so they survive into bitcode and reach anything that re-optimizes it
+        if (glofn->value)
+            genlTargetAttrs(gen, glofn->llvmvar, gen->opt->features);
     }
 }
 
@@ -328,6 +400,12 @@ void genlGlobalSyms(GenState *gen, INode *node) {
             for (nodesFor(memonodes, cnt, nodesp)) {
                 ++nodesp; --cnt;
                 FnDclNode *fnnode = (FnDclNode *)*nodesp;
+                // An instance that generates the same code as an earlier one
+                // is given that one's function, under that one's name
+                if (fnnode->runsame) {
+                    fnnode->llvmvar = fnnode->runsame->llvmvar;
+                    continue;
+                }
                 genlGloFnName(gen, fnnode);
                 // Ensure that linker only picks one generic instantiation across multiple object files
                 LLVMSetLinkage(fnnode->llvmvar, LLVMLinkOnceAnyLinkage);
@@ -343,8 +421,10 @@ void genlGlobalSyms(GenState *gen, INode *node) {
     case FnOverloadDclTag: {
         uint32_t ovlcnt;
         INode **ovlnodesp;
-        for (nodesFor(((FnOverloadDclNode*)node)->overloads, ovlcnt, ovlnodesp))
-            genlGlobalSyms(gen, *ovlnodesp);
+        for (nodesFor(((FnOverloadDclNode*)node)->overloads, ovlcnt, ovlnodesp)) {
+            if (inodeIsReached(*ovlnodesp))
+                genlGlobalSyms(gen, *ovlnodesp);
+        }
         break;
     }
     }
@@ -395,7 +475,8 @@ void genlGlobalImpl(GenState *gen, INode *node) {
             INode **nodesp;
             for (nodesFor(memonodes, cnt, nodesp)) {
                 ++nodesp; --cnt;
-                genlFn(gen, (FnDclNode*)*nodesp);
+                if (((FnDclNode*)*nodesp)->runsame == NULL)
+                    genlFn(gen, (FnDclNode*)*nodesp);
             }
         }
         else if (((FnDclNode*)node)->value) {
@@ -422,12 +503,32 @@ void genlProgram(GenState *gen, ProgramNode *pgm) {
 
     assert(pgm->tag == ProgramTag);
     gen->module = LLVMModuleCreateWithNameInContext(gen->opt->srcname, gen->context);
+    genlSetTarget(gen, gen->module);
     if (!gen->opt->release) {
         gen->dibuilder = LLVMCreateDIBuilder(gen->module);
         gen->difile = LLVMDIBuilderCreateFile(gen->dibuilder, gen->opt->srcpath, strlen(gen->opt->srcpath), ".", 1);
         // The compile unit is attached to the module; nothing reads it back
         LLVMDIBuilderCreateCompileUnit(gen->dibuilder, LLVMDWARFSourceLanguageC,
             gen->difile, "Cone compiler", 13, 0, "", 0, 0, "", 0, LLVMDWARFEmissionFull, 0, 0, 0, "", 0, "", 0);
+        // Without a version, reading the module back from bitcode -- as every
+        // codegen unit does -- silently strips all of its debug info
+        LLVMAddModuleFlag(gen->module, LLVMModuleFlagBehaviorWarning, "Debug Info Version", 18,
+            LLVMValueAsMetadata(LLVMConstInt(LLVMInt32TypeInContext(gen->context), LLVMDebugMetadataVersion(), 0)));
+    }
+
+    // Each function's locals are promoted to registers and its code simplified
+    // as soon as it is generated, so the module the optimizer gets is already
+    // much smaller than the one generation spells out. Inlining and the other
+    // passes that need the whole module still run there, in genlOptimize.
+    // A pipeline given by --passes is run as given, on the IR as generated.
+    gen->fnpasses = NULL;
+    if (gen->opt->opt_level != '0' && gen->opt->passes == NULL) {
+        gen->fnpasses = LLVMCreateFunctionPassManagerForModule(gen->module);
+        LLVMAddPromoteMemoryToRegisterPass(gen->fnpasses);
+        LLVMAddScalarReplAggregatesPass(gen->fnpasses);
+        LLVMAddInstructionCombiningPass(gen->fnpasses);
+        LLVMAddCFGSimplificationPass(gen->fnpasses);
+        LLVMInitializeFunctionPassManager(gen->fnpasses);
     }
 
     // First, generate global symbols for all modules, so that forward references succeed
@@ -440,8 +541,9 @@ void genlProgram(GenState *gen, ProgramNode *pgm) {
         uint32_t icnt;
         INode **inodesp;
         for (nodesFor(mod->nodes, icnt, inodesp)) {
-            // generate node's global name only if not a private name in a non-generating module
-            if (generating || !inodeIsPrivate(*inodesp))
+            // generate node's global name only if not a private name in a non-generating module,
+            // and there only if the program reached it (see modTypeCheck)
+            if (generating || (!inodeIsPrivate(*inodesp) && inodeIsReached(*inodesp)))
                 genlGlobalSyms(gen, *inodesp);
         }
     }
@@ -460,16 +562,34 @@ void genlProgram(GenState *gen, ProgramNode *pgm) {
         }
     }
 
+    if (gen->fnpasses) {
+        LLVMFinalizeFunctionPassManager(gen->fnpasses);
+        LLVMDisposePassManager(gen->fnpasses);
+        gen->fnpasses = NULL;
+    }
     if (!gen->opt->release)
         LLVMDIBuilderFinalize(gen->dibuilder);
 }
 
+// Create a target machine for the target chosen by the options.
+// It neither initializes LLVM nor reports errors, so a codegen unit may call it
+// from its own thread: a target machine may not be shared between threads.
+LLVMTargetMachineRef genlNewMachine(LLVMTargetRef target, ConeOptions *opt) {
+    LLVMCodeGenOptLevel opt_level;
+    switch (opt->opt_level) {
+    case '0': opt_level = LLVMCodeGenLevelNone; break;
+    case '1': opt_level = LLVMCodeGenLevelLess; break;
+    case '3': opt_level = LLVMCodeGenLevelAggressive; break;
+    default: opt_level = LLVMCodeGenLevelDefault; break;  // 2, s and z
+    }
+    LLVMRelocMode reloc = (opt->pic || opt->library)? LLVMRelocPIC : LLVMRelocDefault;
+    return LLVMCreateTargetMachine(target, opt->triple, opt->cpu, opt->features, opt_level, reloc, LLVMCodeModelDefault);
+}
+
 // Use provided options (triple, etc.) to creation a machine
 LLVMTargetMachineRef genlCreateMachine(ConeOptions *opt) {
     char *err;
     LLVMTargetRef target;
-    LLVMCodeGenOptLevel opt_level;
-    LLVMRelocMode reloc;
     LLVMTargetMachineRef machine;
 
     LLVMInitializeAllTargetInfos();
@@ -477,24 +597,60 @@ LLVMTargetMachineRef genlCreateMachine(ConeOptions *opt) {
     LLVMInitializeAllTargets();
     LLVMInitializeAllAsmPrinters();
     LLVMInitializeAllAsmParsers();
+    LLVMInitializeAllDisassemblers();
 
-    // Find target for the specified triple
+    // Find target for the specified triple. A triple naming the host is not a cross build.
+    char *hosttriple = LLVMGetDefaultTargetTriple();
+    int cross = 0;
     if (!opt->triple)
-        opt->triple = LLVMGetDefaultTargetTriple();
+        opt->triple = hosttriple;
+    else {
+        char *triple = LLVMNormalizeTargetTriple(opt->triple);
+        char *host = LLVMNormalizeTargetTriple(hosttriple);
+        cross = strcmp(triple, host) != 0;
+        LLVMDisposeMessage(triple);
+        LLVMDisposeMessage(host);
+    }
     if (LLVMGetTargetFromTriple(opt->triple, &target, &err) != 0) {
         errorMsg(ErrorGenErr, "Could not create target: %s", err);
         LLVMDisposeMessage(err);
         return NULL;
     }
 
-    // Create a specific target machine
-    opt_level = opt->release? LLVMCodeGenLevelAggressive : LLVMCodeGenLevelNone;
-    reloc = (opt->pic || opt->library)? LLVMRelocPIC : LLVMRelocDefault;
+    // Create a specific target machine. A host build tunes for, and uses every
+    // feature of, the CPU it runs on; a cross build cannot know that CPU.
     if (!opt->cpu)
-        opt->cpu = "generic";
+        opt->cpu = cross? "generic" : "native";
+    // The JIT puts a program wherever it finds memory, which is rarely in the
+    // low 4 GiB that code built for a static executable assumes it is loaded at
+    if (opt->run) {
+        if (cross) {
+            errorMsg(ErrorGenErr, "--run runs the program here, so it cannot be used when cross-compiling to %s", opt->triple);
+            return NULL;
+        }
+        opt->pic = 1;
+    }
+    if (strcmp(opt->cpu, "native") == 0) {
+        if (cross) {
+            errorMsg(ErrorGenErr, "--cpu=native cannot be used when cross-compiling to %s", opt->triple);
+            return NULL;
+        }
+        opt->cpu = LLVMGetHostCPUName();
+        char *hostfeatures = LLVMGetHostCPUFeatures();
+        // Explicit --features come last, so they override what the host detected
+        if (opt->features && *opt->features) {
+            char *features = memAllocStr(hostfeatures, strlen(hostfeatures) + strlen(opt->features) + 1);
+            strcat(features, ",");
+            strcat(features, opt->features);
+            opt->features = features;
+            LLVMDisposeMessage(hostfeatures);
+        }
+        else
+            opt->features = hostfeatures;
+    }
     if (!opt->features)
         opt->features = "";
-    if (!(machine = LLVMCreateTargetMachine(target, opt->triple, opt->cpu, opt->features, opt_level, reloc, LLVMCodeModelDefault))) {
+    if (!(machine = genlNewMachine(target, opt))) {
         errorMsg(ErrorGenErr, "Could not create target machine");
         return NULL;
     }
@@ -502,29 +658,132 @@ LLVMTargetMachineRef genlCreateMachine(ConeOptions *opt) {
     return machine;
 }
 
-// Generate requested object file
-void genlOut(char *objpath, char *asmpath, LLVMModuleRef mod, char *triple, LLVMTargetMachineRef machine) {
-    char *err;
-    LLVMTargetDataRef dataref;
-    char *layout;
-
-    LLVMSetTarget(mod, triple);
-    dataref = LLVMCreateTargetDataLayout(machine);
-    layout = LLVMCopyStringRepOfTargetData(dataref);
+// Record the target a module is generated for in it. Every pass that runs over
+// the module, from the first function's on, can then see the target's types.
+void genlSetTarget(GenState *gen, LLVMModuleRef mod) {
+    LLVMSetTarget(mod, gen->opt->triple);
+    char *layout = LLVMCopyStringRepOfTargetData(gen->datalayout);
     LLVMSetDataLayout(mod, layout);
     LLVMDisposeMessage(layout);
+}
+
+// Generate requested object file
+void genlOut(char *objpath, char *asmpath, char *lstpath, LLVMModuleRef mod, LLVMTargetMachineRef machine) {
+    char *err;
 
-    // Generate assembly file if requested
-    if (asmpath && LLVMTargetMachineEmitToFile(machine, mod, asmpath, LLVMAssemblyFile, &err) != 0) {
-        errorMsg(ErrorGenErr, "Could not emit asm file: %s", err);
+    // Generate .o or .obj file, and the assembly and listing files if requested
+    char *failed = genlEmit(machine, mod, objpath, asmpath, lstpath, &err);
+    if (failed) {
+        errorMsg(ErrorGenErr, "Could not %s: %s", failed, err);
         LLVMDisposeMessage(err);
     }
+}
 
-    // Generate .o or .obj file
-    if (LLVMTargetMachineEmitToFile(machine, mod, objpath, LLVMObjectFile, &err) != 0) {
-        errorMsg(ErrorGenErr, "Could not emit obj file: %s", err);
-        LLVMDisposeMessage(err);
+// Write a module as LLVM bitcode, for --lto to link with others. It keeps the
+// target it was generated for, as an object would.
+void genlWriteBitcode(LLVMModuleRef mod, char *bcpath) {
+    if (LLVMWriteBitcodeToFile(mod, bcpath) != 0)
+        errorMsg(ErrorGenErr, "Could not write bitcode file: %s", bcpath);
+}
+
+// Run LLVM's optimization pipeline over a module: the standard one for the
+// --opt level, or whatever --passes spells out instead. The target machine is
+// what tells the vectorizer and the inliner what the target's instructions cost.
+// Bitcode for --lto gets the pre-link half of the pipeline, which leaves out
+// what is better done once the whole program is there, and --lto the other half.
+// Returns NULL, or why the pipeline could not run (dispose with LLVMDisposeMessage).
+// A codegen unit runs this on its own thread, against a module in its own context.
+char *genlOptimize(ConeOptions *opt, LLVMModuleRef mod, LLVMTargetMachineRef machine) {
+    char level[24];
+    char *passes = opt->passes;
+    if (passes == NULL) {
+        sprintf(level, opt->lto? "lto<O%c>" : opt->emit_bc? "lto-pre-link<O%c>" : "default<O%c>", opt->opt_level);
+        passes = level;
+    }
+
+    // Profiling comes first, once each function has been cleaned up as it was
+    // generated, so that there are fewer edges to count. Instrumentation's
+    // counters are lowered straight away. A profile's counts become branch
+    // weights and entry counts, for the inliner and block placement to weigh.
+    // Bitcode had this done before --lto links it.
+    char *profiling = opt->lto? NULL
+        : opt->profile_generate? "pgo-instr-gen,instrprof,"
+        : opt->profile_use? "pgo-instr-use," : NULL;
+    char *pipeline = NULL;
+    if (profiling) {
+        // Not from the arena: a codegen unit runs this on its own thread
+        pipeline = malloc(strlen(profiling) + strlen(passes) + 1);
+        if (pipeline == NULL)
+            errorExit(ExitMem, "Error: Out of memory");
+        strcpy(pipeline, profiling);
+        strcat(pipeline, passes);
+        passes = pipeline;
     }
+
+    // Which loop transformations each level wants, as clang chooses them:
+    // -Oz gives up loop vectorization for size, but not SLP vectorization
+    int speed = opt->opt_level == '2' || opt->opt_level == '3';
+    int size = opt->opt_level == 's' || opt->opt_level == 'z';
+    LLVMPassBuilderOptionsRef pbopts = LLVMCreatePassBuilderOptions();
+    LLVMPassBuilderOptionsSetLoopVectorization(pbopts, speed || opt->opt_level == 's');
+    LLVMPassBuilderOptionsSetLoopInterleaving(pbopts, speed || opt->opt_level == 's');
+    LLVMPassBuilderOptionsSetSLPVectorization(pbopts, speed || size);
+    LLVMPassBuilderOptionsSetLoopUnrolling(pbopts, speed || size);
+
+    LLVMErrorRef error = LLVMRunPasses(mod, passes, machine, pbopts);
+    LLVMDisposePassBuilderOptions(pbopts);
+    free(pipeline);
+    if (error == NULL)
+        return NULL;
+    char *errmsg = LLVMGetErrorMessage(error);
+    char *msg = LLVMCreateMessage(errmsg);
+    LLVMDisposeErrorMessage(errmsg);
+    return msg;
+}
+
+// Give LLVM's profile reader the --profile-use file. pgo-instr-use has no
+// parameter for it, so it is named the only way the C API can: as an LLVM
+// command-line option, which can be set only once a process. LLVM takes a
+// missing profile, or one that is not an indexed profile, for a fatal error
+// that it reports and exits on itself, so both are looked for here first.
+static void genlProfileUse(ConeOptions *opt) {
+    static int named = 0;
+    if (opt->profile_use == NULL || opt->lto || named)
+        return;
+    FILE *profile = fopen(opt->profile_use, "rb");
+    if (profile == NULL)
+        errorExit(ExitNF, "Cannot read profile %s", opt->profile_use);
+    // An indexed profile starts "\xfflprofi\x81", whatever the host's byte order
+    char magic[8];
+    size_t got = fread(magic, 1, sizeof(magic), profile);
+    fclose(profile);
+    if (got != sizeof(magic) || memcmp(magic, "\xfflprofi\x81", sizeof(magic)) != 0) {
+        errorMsg(ErrorGenErr, "%s is not an indexed profile. Write it with llvm-profdata merge.", opt->profile_use);
+        opt->profile_use = NULL;
+        return;
+    }
+
+    char *argv[2];
+    argv[0] = "conec";
+    argv[1] = memAllocStr("-pgo-test-profile-file=", strlen(opt->profile_use) + 23);
+    strcat(argv[1], opt->profile_use);
+    LLVMParseCommandLineOptions(2, (const char *const *)argv, NULL);
+    named = 1;
+}
+
+// The path of the object file a compile with these options writes
+char *genlObjPath(ConeOptions *opt) {
+    return fileMakePath(opt->output, opt->srcname, opt->wasm? "wasm" : objext);
+}
+
+// The path of the assembly --asm asks for
+char *genlAsmPath(ConeOptions *opt) {
+    return fileMakePath(opt->output, opt->srcname, opt->wasm? "wat" : asmext);
+}
+
+// The path of the disassembly listing --listing asks for
+char *genlLstPath(ConeOptions *opt) {
+    return fileMakePath(opt->output, opt->srcname, "lst");
 }
 
 // Generate IR nodes into LLVM IR using LLVM
@@ -532,11 +791,17 @@ void genpgm(GenState *gen, ProgramNode *pgm) {
     char *err;
 
     // Generate IR to LLVM IR 
+    if (timerTracing)
+        timerTraceBegin("GenProgram", NULL);
     genlProgram(gen, pgm);
+    if (timerTracing)
+        timerTraceEnd();
 
     // Verify generated IR
     if (gen->opt->verify) {
         timerBegin(VerifyTimer);
+        if (timerTracing)
+            timerTraceBegin("Verify", NULL);
         char *error = NULL;
         LLVMVerifyModule(gen->module, LLVMReturnStatusAction, &error);
         if (error) {
@@ -544,6 +809,8 @@ void genpgm(GenState *gen, ProgramNode *pgm) {
                 errorMsg(ErrorGenErr, "Module verification failed:\n%s", error);
             LLVMDisposeMessage(error);
         }
+        if (timerTracing)
+            timerTraceEnd();
     }
 
     // Serialize the LLVM IR, if requested
@@ -552,18 +819,32 @@ void genpgm(GenState *gen, ProgramNode *pgm) {
         LLVMDisposeMessage(err);
     }
 
+    char *objx = gen->opt->wasm? "wasm" : objext;
+    char *asmx = gen->opt->wasm? "wat" : asmext;
+
+    genlProfileUse(gen->opt);
+
+    // Split optimization and code generation across threads, if requested.
+    // A program that is run is compiled by the JIT, which takes the module whole,
+    // and bitcode is written whole.
+    if (gen->opt->codegen_units > 1 && !gen->opt->run && !gen->opt->emit_bc && gen->machine && genlUnits(gen, objx, asmx)) {
+        LLVMDisposeModule(gen->module);
+        return;
+    }
+
     // Optimize the generated LLVM IR
     timerBegin(OptTimer);
-    LLVMPassManagerRef passmgr = LLVMCreatePassManager();
-    LLVMAddPromoteMemoryToRegisterPass(passmgr);     // Demote allocas to registers.
-    //LLVMAddInstructionCombiningPass(passmgr);        // Do simple "peephole" and bit-twiddling optimizations
-    LLVMAddReassociatePass(passmgr);                 // Reassociate expressions.
-    LLVMAddGVNPass(passmgr);                         // Eliminate common subexpressions.
-    LLVMAddCFGSimplificationPass(passmgr);           // Simplify the control flow graph
-    if (gen->opt->release)
-        LLVMAddFunctionInliningPass(passmgr);        // Function inlining
-    LLVMRunPassManager(passmgr, gen->module);
-    LLVMDisposePassManager(passmgr);
+    if (timerTracing)
+        timerTraceBegin("Optimize", NULL);
+    char *opterr = genlOptimize(gen->opt, gen->module, gen->machine);
+    if (timerTracing)
+        timerTraceEnd();
+    if (opterr) {
+        errorMsg(ErrorGenErr, "Could not optimize: %s", opterr);
+        LLVMDisposeMessage(opterr);
+        LLVMDisposeModule(gen->module);
+        return;
+    }
 
     // Serialize the LLVM IR, if requested
     if (gen->opt->print_llvmir && LLVMPrintModuleToFile(gen->module, fileMakePath(gen->opt->output, gen->opt->srcname, "ir"), &err) != 0) {
@@ -571,12 +852,21 @@ void genpgm(GenState *gen, ProgramNode *pgm) {
         LLVMDisposeMessage(err);
     }
 
-    // Transform IR to target's ASM and OBJ
+    // Transform IR to target's ASM and OBJ, or to code in memory to run now
     timerBegin(CodeGenTimer);
-    if (gen->machine)
-        genlOut(fileMakePath(gen->opt->output, gen->opt->srcname, gen->opt->wasm? "wasm" : objext),
-            gen->opt->print_asm? fileMakePath(gen->opt->output, gen->opt->srcname, gen->opt->wasm? "wat" : asmext) : NULL,
-            gen->module, gen->opt->triple, gen->machine);
+    if (timerTracing)
+        timerTraceBegin("Codegen", NULL);
+    if (gen->opt->run)
+        genlJit(gen);
+    else if (gen->opt->emit_bc)
+        genlWriteBitcode(gen->module, fileMakePath(gen->opt->output, gen->opt->srcname, "bc"));
+    else if (gen->machine)
+        genlOut(genlObjPath(gen->opt),
+            gen->opt->print_asm? genlAsmPath(gen->opt) : NULL,
+            gen->opt->print_listing? genlLstPath(gen->opt) : NULL,
+            gen->module, gen->machine);
+    if (timerTracing)
+        timerTraceEnd();
 
     LLVMDisposeModule(gen->module);
     // LLVMContextDispose(gen.context);  // Only need if we created a new context
@@ -597,7 +887,8 @@ static int genlComdatSupport(char *triple) {
     return ComdatFull;
 }
 
-void genSetup(GenState *gen, ConeOptions *opt) {
+// Set up the target machine the options choose, and what follows from it
+void genSetupTarget(GenState *gen, ConeOptions *opt) {
     gen->opt = opt;
 
     LLVMTargetMachineRef machine = genlCreateMachine(opt);
@@ -608,16 +899,20 @@ void genSetup(GenState *gen, ConeOptions *opt) {
     gen->machine = machine;
     gen->datalayout = LLVMCreateTargetDataLayout(machine);
     opt->ptrsize = LLVMPointerSize(gen->datalayout) << 3;
+    gen->comdats = genlComdatSupport(opt->triple);   // genlCreateMachine filled in the default
+}
+
+void genSetup(GenState *gen, ConeOptions *opt) {
+    genSetupTarget(gen, opt);
 
     gen->context = LLVMGetGlobalContext(); // LLVM inlining bugs prevent use of LLVMContextCreate();
     gen->builder = LLVMCreateBuilder();
     gen->fn = NULL;
     gen->fnblock = NULL;
     gen->allocaPoint = NULL;
-    gen->blockstack = memAllocBlk(sizeof(GenBlockState)*GenBlockStackMax);
+    gen->blockstack = memAllocFor(MemGenCat, sizeof(GenBlockState)*GenBlockStackMax);
     gen->blockstackcnt = 0;
-
-    gen->comdats = genlComdatSupport(opt->triple);   // genlCreateMachine filled in the default
+    gen->jit = NULL;
     gen->emptyStructType = genlEmptyStruct(gen);
 }
 
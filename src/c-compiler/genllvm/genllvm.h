@@ -14,6 +14,8 @@
 #include <llvm-c/Core.h>
 #include <llvm-c/DebugInfo.h>
 #include <llvm-c/ExecutionEngine.h>
+#include <llvm-c/LLJIT.h>
+#include <llvm-c/TargetMachine.h>
 
 // An entry for each active loop block in current control flow stack
 #define GenBlockStackMax 256
@@ -34,12 +36,16 @@ typedef struct GenState {
     LLVMValueRef fn;
     LLVMValueRef allocaPoint;
     LLVMBuilderRef builder;
+    LLVMPassManagerRef fnpasses;    // Cleans up each function as soon as it is generated, or NULL
 
     LLVMDIBuilderRef dibuilder;
     LLVMMetadataRef difile;
 
     LLVMTypeRef emptyStructType;
 
+    LLVMOrcLLJITRef jit;    // With --run, the JIT holding the compiled program
+    LLVMOrcJITTargetAddress jitmain;   // ... and the address of its main
+
     ConeOptions *opt;
     int comdats;            // enum ComdatSupport, from the target's object format
     INode *fnblock;
@@ -63,13 +69,62 @@ enum FnCallDispatch {
 
 // Setup LLVM generation, ensuring we know intended target
 void genSetup(GenState *gen, ConeOptions *opt);
+// Set up only the target machine, as a compile server's request does when
+// the server's is not the one its options choose
+void genSetupTarget(GenState *gen, ConeOptions *opt);
 void genClose(GenState *gen);
 void genpgm(GenState *gen, ProgramNode *pgm);
+// The path of the object file a compile with these options writes
+char *genlObjPath(ConeOptions *opt);
+// The path of the assembly --asm asks for
+char *genlAsmPath(ConeOptions *opt);
+// The path of the disassembly listing --listing asks for
+char *genlLstPath(ConeOptions *opt);
+// Emit a module's object, and its assembly and listing if their paths are given, for the target
+void genlOut(char *objpath, char *asmpath, char *lstpath, LLVMModuleRef mod, LLVMTargetMachineRef machine);
+// Record the target's triple and data layout in a module
+void genlSetTarget(GenState *gen, LLVMModuleRef mod);
+// Create a target machine for the target the options chose
+LLVMTargetMachineRef genlNewMachine(LLVMTargetRef target, ConeOptions *opt);
+// Run the --opt level's (or --passes') optimization pipeline over a module
+char *genlOptimize(ConeOptions *opt, LLVMModuleRef mod, LLVMTargetMachineRef machine);
+// Write a module as LLVM bitcode, for --lto to link with others
+void genlWriteBitcode(LLVMModuleRef mod, char *bcpath);
+
+// genlemit.c
+// Emit a module's object and, if their paths are given, its assembly and its
+// listing. The listing is disassembled from the object, with no second code generator run.
+char *genlEmit(LLVMTargetMachineRef machine, LLVMModuleRef mod, char *objpath, char *asmpath, char *lstpath, char **errmsg);
+
 void genlFn(GenState *gen, FnDclNode *fnnode);
+// Generate a function's body into its LLVM function, fnnode->llvmvar
+void genlFnBody(GenState *gen, FnDclNode *fnnode);
 void genlComdat(GenState *gen, LLVMValueRef global);
+void genlSubprogram(GenState *gen, FnDclNode *glofn, LLVMValueRef fn);
+void genlTargetAttrs(GenState *gen, LLVMValueRef fn, char *features);
 void genlGloVarName(GenState *gen, VarDclNode *glovar);
 void genlGloFnName(GenState *gen, FnDclNode *glofn);
 
+// genlclones.c
+// Generate a '@target_clones' function: a version of its body per feature set,
+// and the public symbol that dispatches to the best one the CPU can run
+void genlFnClones(GenState *gen, FnDclNode *fnnode);
+
+// genljit.c
+// Compile the optimized module into this process, for --run, and find its main
+void genlJit(GenState *gen);
+// Call the program's main with these arguments, and return its exit status
+int genlJitRun(GenState *gen, int argc, char **argv);
+
+// genllto.c
+// Link bitcode files into one module, optimize it as a whole program, and emit it
+void genlLto(GenState *gen, char **paths, int npaths);
+
+// genlunits.c
+// Optimize and emit the module as parallel codegen units.
+// Returns 0, having done nothing, when the module is too small to split.
+int genlUnits(GenState *gen, char *objext, char *asmext);
+
 // genlstmt.c
 LLVMBasicBlockRef genlInsertBlock(GenState *gen, char *name);
 LLVMValueRef genlBlock(GenState *gen, BlockNode *blk);
@@ -94,6 +149,10 @@ void genlRcCounter(GenState *gen, LLVMValueRef ref, long long amount, RefNode *r
 void genlDealiasOwn(GenState *gen, LLVMValueRef ref, RefNode *refnode);
 // Create an alloca (will be pushed to the entry point of the function.
 LLVMValueRef genlAlloca(GenState *gen, LLVMTypeRef type, const char *name);
+// Is a local variable or parameter its value, with no storage of its own?
+int genlVarIsValue(VarDclNode *var);
+// Bind a local variable or parameter to its initial value
+void genlVarBind(GenState *gen, VarDclNode *var, LLVMValueRef val);
 
 // genltype.c
 // Generate a type value
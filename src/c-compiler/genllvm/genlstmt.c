@@ -108,8 +108,8 @@ LLVMValueRef genlBlock(GenState *gen, BlockNode *blk) {
         // different conditions, so a void block built a phi over an uninitialized
         // count and emitted one with no incoming entries.
         if (blk->vtype->tag != VoidTag && blk->vtype->tag != UnknownTag) {
-            blkstate->phis = (LLVMValueRef*)memAllocBlk(sizeof(LLVMValueRef) * blk->breaks->used);
-            blkstate->blocksFrom = (LLVMBasicBlockRef*)memAllocBlk(sizeof(LLVMBasicBlockRef) * blk->breaks->used);
+            blkstate->phis = (LLVMValueRef*)memAllocFor(MemGenCat, sizeof(LLVMValueRef) * blk->breaks->used);
+            blkstate->blocksFrom = (LLVMBasicBlockRef*)memAllocFor(MemGenCat, sizeof(LLVMBasicBlockRef) * blk->breaks->used);
         }
         else {
             blkstate->phis = NULL;
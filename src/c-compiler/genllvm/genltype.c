@@ -70,7 +70,7 @@ void genlVtableImpl(GenState *gen, VtableImpl *impl, LLVMTypeRef vtableRef) {
 // Generate a vtable type
 void genlVtable(GenState *gen, Vtable *vtable) {
     uint32_t fieldcnt = vtable->methfld->used;
-    LLVMTypeRef *field_types = (LLVMTypeRef *)memAllocBlk(fieldcnt * sizeof(LLVMTypeRef));
+    LLVMTypeRef *field_types = (LLVMTypeRef *)memAllocFor(MemGenCat, fieldcnt * sizeof(LLVMTypeRef));
     LLVMTypeRef *field_type_ptr = field_types;
 
     // Declare vtable's fields
@@ -81,7 +81,7 @@ void genlVtable(GenState *gen, Vtable *vtable) {
             // Generate a pointer to function signature
             // Note: parm types are not specified to avoid LLVM type check errors on self parm
             FnSigNode *fnsig = (FnSigNode*)itypeGetTypeDcl(((FnDclNode *)*nodesp)->vtype);
-            LLVMTypeRef *param_types = (LLVMTypeRef *)memAllocBlk(fnsig->parms->used * sizeof(LLVMTypeRef));
+            LLVMTypeRef *param_types = (LLVMTypeRef *)memAllocFor(MemGenCat, fnsig->parms->used * sizeof(LLVMTypeRef));
             LLVMTypeRef *parm = param_types;
             INode **nodesp;
             uint32_t cnt;
@@ -108,7 +108,7 @@ void genlVtable(GenState *gen, Vtable *vtable) {
 
     // Build all the vtable globals that implement the vtable
     // as well as an array pointing to all these vtables
-    LLVMValueRef *vtables = (LLVMValueRef *)memAllocBlk(vtable->impl->used * sizeof(LLVMValueRef *));
+    LLVMValueRef *vtables = (LLVMValueRef *)memAllocFor(MemGenCat, vtable->impl->used * sizeof(LLVMValueRef *));
     LLVMValueRef *vtablesp = vtables;
     for (nodesFor(vtable->impl, cnt, nodesp)) {
         genlVtableImpl(gen, (VtableImpl*)*nodesp, vtableRef);
@@ -148,7 +148,7 @@ LLVMTypeRef genlStructFields(GenState *gen, LLVMTypeRef structype, StructNode *s
     // Add struct's fields (body) to type
     INode **nodesp;
     uint32_t cnt;
-    LLVMTypeRef *field_types = (LLVMTypeRef *)memAllocBlk(fieldcnt * sizeof(LLVMTypeRef));
+    LLVMTypeRef *field_types = (LLVMTypeRef *)memAllocFor(MemGenCat, fieldcnt * sizeof(LLVMTypeRef));
     LLVMTypeRef *field_type_ptr = field_types;
     for (nodelistFor(&strnode->fields, cnt, nodesp)) {
         *field_type_ptr++ = genlType(gen, ((FieldDclNode *)*nodesp)->vtype);
@@ -236,7 +236,7 @@ void genlSameSizeTrait(GenState *gen, StructNode *base) {
     // Remember the largest size
     StructNode *maxStruct = NULL;
     unsigned long long maxsize = 0;
-    unsigned long long *sizes = (unsigned long long *)memAllocBlk(base->derived->used * sizeof(unsigned long long));
+    unsigned long long *sizes = (unsigned long long *)memAllocFor(MemGenCat, base->derived->used * sizeof(unsigned long long));
     unsigned long long *sizesp = sizes;
     for (nodesFor(base->derived, cnt, nodesp)) {
         StructNode *strnode = (StructNode *)*nodesp;
@@ -329,7 +329,7 @@ LLVMTypeRef _genlType(GenState *gen, char *name, INode *typ) {
     {
         // Build typeref from function signature
         FnSigNode *fnsig = (FnSigNode*)typ;
-        LLVMTypeRef *param_types = (LLVMTypeRef *)memAllocBlk(fnsig->parms->used * sizeof(LLVMTypeRef));
+        LLVMTypeRef *param_types = (LLVMTypeRef *)memAllocFor(MemGenCat, fnsig->parms->used * sizeof(LLVMTypeRef));
         LLVMTypeRef *parm = param_types;
         INode **nodesp;
         uint32_t cnt;
@@ -393,7 +393,7 @@ LLVMTypeRef _genlType(GenState *gen, char *name, INode *typ) {
         INode **nodesp;
         uint32_t cnt;
         uint32_t propcount = tuple->elems->used;
-        LLVMTypeRef *typerefs = (LLVMTypeRef *)memAllocBlk(propcount * sizeof(LLVMTypeRef));
+        LLVMTypeRef *typerefs = (LLVMTypeRef *)memAllocFor(MemGenCat, propcount * sizeof(LLVMTypeRef));
         LLVMTypeRef *typerefp = typerefs;
         for (nodesFor(tuple->elems, cnt, nodesp)) {
             *typerefp++ = genlType(gen, *nodesp);
@@ -448,6 +448,14 @@ LLVMTypeRef genlType(GenState *gen, INode *typ) {
         genlRefTypeSetup(gen, reftype);
         return reftype->typeinfo->llvmtyperef = _genlType(gen, "", dcltype);
     }
+    // An interned pointer, array or tuple type is the one node for it, which
+    // can remember its LLVM type as a named type does
+    else if (dcltype->flags & InternedType) {
+        ITypeNode *interned = (ITypeNode*)dcltype;
+        if (interned->llvmtype == NULL)
+            interned->llvmtype = _genlType(gen, "", dcltype);
+        return interned->llvmtype;
+    }
     else
         return _genlType(gen, "", dcltype);
 }
@@ -0,0 +1,521 @@
+/** Parallel optimization and code generation, in codegen units
+ * @file
+ *
+ * LLVM's optimizer and code generator are where nearly all compile time goes,
+ * and each works through a module on one thread. With --codegen-units the
+ * finished module is partitioned by function instead, and each partition -- a
+ * "unit" -- is optimized and emitted on its own thread, into its own object.
+ *
+ * Units may share nothing mutable, and an LLVM context owns every type, constant
+ * and piece of metadata a module uses. So the module is written to bitcode in
+ * memory once, and every unit reads its own copy of it into its own context.
+ * A unit then keeps the bodies of the functions assigned to it and declares
+ * the rest, which the other units define.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "../ir/ir.h"
+#include "../shared/error.h"
+#include "../shared/memory.h"
+#include "../shared/timer.h"
+#include "../shared/fileio.h"
+#include "../coneopts.h"
+#include "genllvm.h"
+
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Comdat.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// The stack each unit's thread gets. LLVM's code generator recurses deeply on
+// large functions, and a Windows thread otherwise gets only 1 MiB.
+#define GenlUnitStackSize (8 << 20)
+
+// What every unit's thread reads, and none writes
+typedef struct {
+    ConeOptions *opt;
+    LLVMTargetRef target;
+    const char *bitcode;
+    size_t bitcodesize;
+    int32_t *fnunit;    // Unit owning each function, in module order. -1: every unit
+} GenlUnitsShared;
+
+// One codegen unit: what it is to produce, and what its thread reports back
+typedef struct {
+    GenlUnitsShared *shared;
+    int32_t index;
+    char *objpath;
+    char *asmpath;      // NULL unless --asm
+    char *lstpath;      // NULL unless --listing
+    char *irtext;       // The optimized LLVM IR, if --llvmir (LLVM-owned)
+    char *failed;       // What the unit could not do, or NULL
+    char *errmsg;       // LLVM's explanation of it (LLVM-owned), or NULL
+    uint64_t began;     // When the unit's thread began, optimizing and emitting
+    uint64_t optimized;
+    uint64_t emitted;
+} GenlUnit;
+
+// One function's place in the module and its share of the work
+typedef struct {
+    uint32_t ordinal;
+    uint32_t size;
+} GenlUnitFn;
+
+// Is this symbol private to its object file?
+static int genlUnitIsLocal(LLVMValueRef global) {
+    LLVMLinkage linkage = LLVMGetLinkage(global);
+    return linkage == LLVMInternalLinkage || linkage == LLVMPrivateLinkage;
+}
+
+// Does anything live still refer to this value? A constant expression that
+// nothing uses any more is not a use: stripping a function body leaves behind
+// the constant GEPs it made of string literals.
+static int genlUnitIsUsed(LLVMValueRef value) {
+    LLVMUseRef use;
+    for (use = LLVMGetFirstUse(value); use; use = LLVMGetNextUse(use)) {
+        LLVMValueRef user = LLVMGetUser(use);
+        if (!LLVMIsAConstant(user) || LLVMIsAGlobalValue(user) || genlUnitIsUsed(user))
+            return 1;
+    }
+    return 0;
+}
+
+// Keep a definition in the unit that owns it.
+// A linkonce definition is one the optimizer may drop once nothing in its own
+// module calls it -- but other units do. Weak linkage still lets the linker
+// merge it with another object file's copy, and forbids the optimizer to drop it.
+static void genlUnitKeep(LLVMValueRef global) {
+    LLVMLinkage linkage = LLVMGetLinkage(global);
+    if (linkage == LLVMLinkOnceAnyLinkage)
+        LLVMSetLinkage(global, LLVMWeakAnyLinkage);
+    else if (linkage == LLVMLinkOnceODRLinkage)
+        LLVMSetLinkage(global, LLVMWeakODRLinkage);
+}
+
+// Turn a function definition into a declaration of it. Every instruction's uses
+// go first, so that nothing is deleted while something else still refers to it.
+// Only a definition may lead a COMDAT or carry a defining subprogram.
+static void genlUnitDeclareFn(LLVMModuleRef mod, LLVMValueRef fn) {
+    LLVMBasicBlockRef block;
+    LLVMValueRef inst;
+    for (block = LLVMGetFirstBasicBlock(fn); block; block = LLVMGetNextBasicBlock(block)) {
+        for (inst = LLVMGetFirstInstruction(block); inst; inst = LLVMGetNextInstruction(inst)) {
+            if (LLVMGetFirstUse(inst))
+                LLVMReplaceAllUsesWith(inst, LLVMGetUndef(LLVMTypeOf(inst)));
+        }
+    }
+    for (block = LLVMGetFirstBasicBlock(fn); block; block = LLVMGetNextBasicBlock(block)) {
+        while ((inst = LLVMGetFirstInstruction(block)))
+            LLVMInstructionEraseFromParent(inst);
+    }
+    while ((block = LLVMGetFirstBasicBlock(fn)))
+        LLVMDeleteBasicBlock(block);
+
+    LLVMSetLinkage(fn, LLVMExternalLinkage);
+    LLVMSetComdat(fn, NULL);
+    LLVMGlobalEraseMetadata(fn, LLVMGetMDKindIDInContext(LLVMGetModuleContext(mod), "dbg", 3));
+}
+
+// Replace a global variable's definition with a declaration of it.
+// The C API cannot take an initializer away, so a new global takes its place.
+static void genlUnitDeclareVar(LLVMModuleRef mod, LLVMValueRef var) {
+    size_t namelen;
+    const char *name = LLVMGetValueName2(var, &namelen);
+    char *namecopy = malloc(namelen + 1);
+    if (namecopy == NULL)
+        errorExit(ExitMem, "Error: Out of memory");
+    memcpy(namecopy, name, namelen);
+    namecopy[namelen] = '\0';
+
+    LLVMValueRef decl = LLVMAddGlobalInAddressSpace(mod, LLVMGlobalGetValueType(var), "",
+        LLVMGetPointerAddressSpace(LLVMTypeOf(var)));
+    LLVMSetGlobalConstant(decl, LLVMIsGlobalConstant(var));
+    LLVMSetVisibility(decl, LLVMGetVisibility(var));
+    LLVMSetDLLStorageClass(decl, LLVMGetDLLStorageClass(var));
+    LLVMSetThreadLocalMode(decl, LLVMGetThreadLocalMode(var));
+    LLVMSetAlignment(decl, LLVMGetAlignment(var));
+
+    LLVMReplaceAllUsesWith(var, decl);
+    LLVMDeleteGlobal(var);
+    LLVMSetValueName2(decl, namecopy, namelen);
+    free(namecopy);
+}
+
+// Replace an ifunc with a declaration of the function it resolves to.
+// Its resolver and the versions it chooses from are then local symbols nothing uses.
+static void genlUnitDeclareIFunc(LLVMModuleRef mod, LLVMValueRef ifunc) {
+    size_t namelen;
+    const char *name = LLVMGetValueName2(ifunc, &namelen);
+    char *namecopy = malloc(namelen + 1);
+    if (namecopy == NULL)
+        errorExit(ExitMem, "Error: Out of memory");
+    memcpy(namecopy, name, namelen);
+    namecopy[namelen] = '\0';
+
+    LLVMValueRef decl = LLVMAddFunction(mod, "", LLVMGlobalGetValueType(ifunc));
+    LLVMSetVisibility(decl, LLVMGetVisibility(ifunc));
+    LLVMReplaceAllUsesWith(ifunc, decl);
+    LLVMEraseGlobalIFunc(ifunc);
+    LLVMSetValueName2(decl, namecopy, namelen);
+    free(namecopy);
+}
+
+// Delete what is private to this unit's object file and that nothing in the unit
+// uses any more. Every unit starts with its own copy of each, because no other
+// object file could refer to it. Deleting one can orphan another, such as the
+// string literal only an anonymous function used, so repeat until none goes.
+static void genlUnitSweep(LLVMModuleRef mod) {
+    int swept;
+    do {
+        swept = 0;
+        LLVMValueRef fn = LLVMGetFirstFunction(mod);
+        while (fn) {
+            LLVMValueRef next = LLVMGetNextFunction(fn);
+            if (genlUnitIsLocal(fn) && !genlUnitIsUsed(fn)) {
+                LLVMReplaceAllUsesWith(fn, LLVMGetUndef(LLVMTypeOf(fn)));
+                LLVMDeleteFunction(fn);
+                swept = 1;
+            }
+            fn = next;
+        }
+        LLVMValueRef var = LLVMGetFirstGlobal(mod);
+        while (var) {
+            LLVMValueRef next = LLVMGetNextGlobal(var);
+            if (genlUnitIsLocal(var) && !genlUnitIsUsed(var)) {
+                LLVMReplaceAllUsesWith(var, LLVMGetUndef(LLVMTypeOf(var)));
+                LLVMDeleteGlobal(var);
+                swept = 1;
+            }
+            var = next;
+        }
+    } while (swept);
+}
+
+// Reduce a unit's copy of the module to the unit's own share of it.
+// - A function with a body and a public symbol is defined by exactly one unit,
+//   and every other unit declares it.
+// - Every public global variable is defined by unit 0, for the same reason,
+//   and so is every ifunc ('@target_clones').
+// - A local symbol (an anonymous function, a string literal) is one no other
+//   object file could name, so each unit defines its own copy, if it uses it.
+static void genlUnitStrip(GenlUnit *unit, LLVMModuleRef mod) {
+    int32_t *fnunit = unit->shared->fnunit;
+    uint32_t ordinal = 0;
+    LLVMValueRef fn;
+    for (fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn), ++ordinal) {
+        if (fnunit[ordinal] < 0)
+            continue;
+        if (fnunit[ordinal] == unit->index)
+            genlUnitKeep(fn);
+        else
+            genlUnitDeclareFn(mod, fn);
+    }
+
+    LLVMValueRef var = LLVMGetFirstGlobal(mod);
+    while (var) {
+        LLVMValueRef next = LLVMGetNextGlobal(var);
+        if (!LLVMIsDeclaration(var) && !genlUnitIsLocal(var)) {
+            if (unit->index == 0)
+                genlUnitKeep(var);
+            else
+                genlUnitDeclareVar(mod, var);
+        }
+        var = next;
+    }
+
+    if (unit->index != 0) {
+        LLVMValueRef ifunc = LLVMGetFirstGlobalIFunc(mod);
+        while (ifunc) {
+            LLVMValueRef next = LLVMGetNextGlobalIFunc(ifunc);
+            genlUnitDeclareIFunc(mod, ifunc);
+            ifunc = next;
+        }
+    }
+
+    genlUnitSweep(mod);
+}
+
+// Optimize and emit a unit's stripped module, with the unit's own target machine
+static void genlUnitEmit(GenlUnit *unit, LLVMModuleRef mod, LLVMTargetMachineRef machine) {
+    ConeOptions *opt = unit->shared->opt;
+    unit->began = timerGet();
+    unit->errmsg = genlOptimize(opt, mod, machine);
+    unit->optimized = unit->emitted = timerGet();
+    if (unit->errmsg) {
+        unit->failed = "optimize";
+        return;
+    }
+    if (opt->print_llvmir)
+        unit->irtext = LLVMPrintModuleToString(mod);
+    unit->failed = genlEmit(machine, mod, unit->objpath, unit->asmpath, unit->lstpath, &unit->errmsg);
+    unit->emitted = timerGet();
+}
+
+// Everything one unit does, start to finish, on its own thread.
+// Nothing here may touch the arena or report an error: neither is thread-safe.
+// A failure is recorded for genlUnits to report once every unit is done.
+static void genlUnitRun(GenlUnit *unit) {
+    GenlUnitsShared *shared = unit->shared;
+    LLVMContextRef context = LLVMContextCreate();
+    LLVMMemoryBufferRef buffer = LLVMCreateMemoryBufferWithMemoryRange(shared->bitcode, shared->bitcodesize, shared->opt->srcname, 0);
+    LLVMModuleRef mod;
+    if (LLVMParseBitcodeInContext2(context, buffer, &mod) != 0)
+        unit->failed = "read the module's bitcode";
+    else {
+        genlUnitStrip(unit, mod);
+        LLVMTargetMachineRef machine = genlNewMachine(shared->target, shared->opt);
+        if (machine == NULL)
+            unit->failed = "create target machine";
+        else {
+            genlUnitEmit(unit, mod, machine);
+            LLVMDisposeTargetMachine(machine);
+        }
+        LLVMDisposeModule(mod);
+    }
+    LLVMDisposeMemoryBuffer(buffer);
+    LLVMContextDispose(context);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI genlUnitThread(LPVOID unit) {
+    genlUnitRun((GenlUnit*)unit);
+    return 0;
+}
+#else
+static void *genlUnitThread(void *unit) {
+    genlUnitRun((GenlUnit*)unit);
+    return NULL;
+}
+#endif
+
+// Run every unit: unit 0 on this thread, each other on a thread of its own.
+// A unit whose thread cannot be started runs here instead, after unit 0.
+static void genlUnitsRunAll(GenlUnit *units, int32_t nunits) {
+    int32_t i;
+#ifdef _WIN32
+    HANDLE *threads = (HANDLE *)memAllocFor(MemGenCat, nunits * sizeof(HANDLE));
+    for (i = 1; i < nunits; ++i)
+        threads[i] = CreateThread(NULL, GenlUnitStackSize, genlUnitThread, &units[i], STACK_SIZE_PARAM_IS_A_RESERVATION, NULL);
+    genlUnitRun(&units[0]);
+    for (i = 1; i < nunits; ++i) {
+        if (threads[i] == NULL)
+            genlUnitRun(&units[i]);
+        else {
+            WaitForSingleObject(threads[i], INFINITE);
+            CloseHandle(threads[i]);
+        }
+    }
+#else
+    pthread_t *threads = (pthread_t *)memAllocFor(MemGenCat, nunits * sizeof(pthread_t));
+    int *started = (int *)memAllocFor(MemGenCat, nunits * sizeof(int));
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, GenlUnitStackSize);
+    for (i = 1; i < nunits; ++i)
+        started[i] = pthread_create(&threads[i], &attr, genlUnitThread, &units[i]) == 0;
+    pthread_attr_destroy(&attr);
+    genlUnitRun(&units[0]);
+    for (i = 1; i < nunits; ++i) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            genlUnitRun(&units[i]);
+    }
+#endif
+}
+
+// Largest first; equal sizes in module order, so the split is reproducible
+static int genlUnitFnCmp(const void *a, const void *b) {
+    const GenlUnitFn *fa = (const GenlUnitFn *)a;
+    const GenlUnitFn *fb = (const GenlUnitFn *)b;
+    if (fa->size != fb->size)
+        return fa->size > fb->size? -1 : 1;
+    return fa->ordinal < fb->ordinal? -1 : 1;
+}
+
+// Choose the unit that owns each function, balancing the units' instruction
+// counts: largest function first, each to the least loaded unit so far.
+// Returns how many units actually have work, which is fewer than asked for when
+// the module has fewer functions to share out than that.
+static int32_t genlUnitsAssign(LLVMModuleRef mod, int32_t nunits, int32_t **fnunitp) {
+    uint32_t nfns = 0;
+    LLVMValueRef fn;
+    for (fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn))
+        ++nfns;
+    int32_t *fnunit = (int32_t *)memAllocFor(MemGenCat, (nfns + 1) * sizeof(int32_t));
+    GenlUnitFn *owned = (GenlUnitFn *)memAllocFor(MemGenCat, (nfns + 1) * sizeof(GenlUnitFn));
+    uint32_t nowned = 0;
+
+    uint32_t ordinal = 0;
+    for (fn = LLVMGetFirstFunction(mod); fn; fn = LLVMGetNextFunction(fn), ++ordinal) {
+        fnunit[ordinal] = -1;
+        if (LLVMIsDeclaration(fn) || genlUnitIsLocal(fn))
+            continue;
+        uint32_t size = 0;
+        LLVMBasicBlockRef block;
+        LLVMValueRef inst;
+        for (block = LLVMGetFirstBasicBlock(fn); block; block = LLVMGetNextBasicBlock(block)) {
+            for (inst = LLVMGetFirstInstruction(block); inst; inst = LLVMGetNextInstruction(inst))
+                ++size;
+        }
+        owned[nowned].ordinal = ordinal;
+        owned[nowned].size = size;
+        ++nowned;
+    }
+    if ((uint32_t)nunits > nowned)
+        nunits = (int32_t)nowned;
+
+    qsort(owned, nowned, sizeof(GenlUnitFn), genlUnitFnCmp);
+    uint64_t *load = (uint64_t *)memAllocFor(MemGenCat, (nunits + 1) * sizeof(uint64_t));
+    memset(load, 0, (nunits + 1) * sizeof(uint64_t));
+    uint32_t i;
+    for (i = 0; i < nowned; ++i) {
+        int32_t least = 0;
+        int32_t unit;
+        for (unit = 1; unit < nunits; ++unit) {
+            if (load[unit] < load[least])
+                least = unit;
+        }
+        fnunit[owned[i].ordinal] = least;
+        load[least] += owned[i].size + 1;
+    }
+
+    *fnunitp = fnunit;
+    return nunits;
+}
+
+// Combine the units' objects into the single object an unsplit compile writes,
+// so that whatever links it does not need to know the compile was split.
+// That takes a linker that can make a relocatable object ('ld -r'), which
+// --linker may name. Microsoft's linker cannot, so on Windows the units'
+// objects are left for the link to name individually.
+static void genlUnitsCombine(ConeOptions *opt, char *objpath, GenlUnit *units, int32_t nunits) {
+#ifdef _WIN32
+    if (opt->verbosity > 0)
+        printf("Codegen units left as %d separate object files\n", nunits);
+#else
+    char *linker = opt->linker? opt->linker : opt->wasm? "wasm-ld" : "ld";
+    size_t cmdlen = strlen(linker) + strlen(objpath) + 16;
+    int32_t i;
+    for (i = 0; i < nunits; ++i)
+        cmdlen += strlen(units[i].objpath) + 3;
+    char *cmd = memAllocStr(NULL, cmdlen);
+    char *cmdp = cmd + sprintf(cmd, "%s -r -o \"%s\"", linker, objpath);
+    for (i = 0; i < nunits; ++i)
+        cmdp += sprintf(cmdp, " \"%s\"", units[i].objpath);
+
+    if (opt->verbosity >= 3)
+        printf("%s\n", cmd);
+    if (system(cmd) != 0) {
+        errorMsg(ErrorGenErr, "Could not combine codegen units into %s with %s", objpath, linker);
+        return;
+    }
+    for (i = 0; i < nunits; ++i)
+        remove(units[i].objpath);
+#endif
+}
+
+// Write every unit's optimized LLVM IR into the one file an unsplit compile writes,
+// each preceded by a comment saying which unit it is
+static void genlUnitsPrintIR(ConeOptions *opt, GenlUnit *units, int32_t nunits) {
+    char *irpath = fileMakePath(opt->output, opt->srcname, "ir");
+    FILE *irfile = fopen(irpath, "wb");
+    if (irfile == NULL)
+        errorMsg(ErrorGenErr, "Could not emit ir file: %s", irpath);
+    int32_t i;
+    for (i = 0; i < nunits; ++i) {
+        if (units[i].irtext == NULL)
+            continue;
+        if (irfile) {
+            fprintf(irfile, "; codegen unit %d of %d\n", i, nunits);
+            fputs(units[i].irtext, irfile);
+        }
+        LLVMDisposeMessage(units[i].irtext);
+    }
+    if (irfile)
+        fclose(irfile);
+}
+
+// Optimize and emit the module as parallel codegen units.
+// Returns 0, having done nothing, when the module is too small to split.
+int genlUnits(GenState *gen, char *objext, char *asmext) {
+    ConeOptions *opt = gen->opt;
+    GenlUnitsShared shared;
+    int32_t nunits = genlUnitsAssign(gen->module, opt->codegen_units, &shared.fnunit);
+    if (nunits < 2)
+        return 0;
+
+    // Optimization and code generation are no longer separable phases: every
+    // unit does both, at the same time as the others
+    timerBegin(CodeGenTimer);
+    if (timerTracing)
+        timerTraceBegin("CodegenUnits", NULL);
+
+    LLVMMemoryBufferRef bitcode = LLVMWriteBitcodeToMemoryBuffer(gen->module);
+    shared.opt = opt;
+    shared.target = LLVMGetTargetMachineTarget(gen->machine);
+    shared.bitcode = LLVMGetBufferStart(bitcode);
+    shared.bitcodesize = LLVMGetBufferSize(bitcode);
+
+    GenlUnit *units = (GenlUnit *)memAllocFor(MemGenCat, nunits * sizeof(GenlUnit));
+    char *unitext = memAllocStr(NULL, 16 + strlen(objext) + strlen(asmext));
+    int32_t i;
+    for (i = 0; i < nunits; ++i) {
+        GenlUnit *unit = &units[i];
+        unit->shared = &shared;
+        unit->index = i;
+        sprintf(unitext, "%d.%s", i, objext);
+        unit->objpath = fileMakePath(opt->output, opt->srcname, unitext);
+        sprintf(unitext, "%d.%s", i, asmext);
+        unit->asmpath = opt->print_asm? fileMakePath(opt->output, opt->srcname, unitext) : NULL;
+        sprintf(unitext, "%d.lst", i);
+        unit->lstpath = opt->print_listing? fileMakePath(opt->output, opt->srcname, unitext) : NULL;
+        unit->irtext = NULL;
+        unit->failed = NULL;
+        unit->errmsg = NULL;
+        unit->began = 0;
+    }
+
+    genlUnitsRunAll(units, nunits);
+    LLVMDisposeMemoryBuffer(bitcode);
+
+    // Each unit's thread timed itself, where nothing could be written, and
+    // the time trace shows it as a thread of its own
+    for (i = 0; i < nunits && timerTracing; ++i) {
+        if (units[i].began == 0)
+            continue;
+        char detail[32];
+        sprintf(detail, "unit %d", i);
+        timerTraceEvent("Optimize", detail, units[i].began, units[i].optimized, i + 1);
+        timerTraceEvent("Codegen", detail, units[i].optimized, units[i].emitted, i + 1);
+    }
+
+    int failed = 0;
+    for (i = 0; i < nunits; ++i) {
+        if (units[i].failed == NULL)
+            continue;
+        failed = 1;
+        errorMsg(ErrorGenErr, "Could not %s for codegen unit %d: %s", units[i].failed, i,
+            units[i].errmsg? units[i].errmsg : "");
+        if (units[i].errmsg)
+            LLVMDisposeMessage(units[i].errmsg);
+    }
+    if (opt->print_llvmir)
+        genlUnitsPrintIR(opt, units, nunits);
+    if (!failed)
+        genlUnitsCombine(opt, fileMakePath(opt->output, opt->srcname, objext), units, nunits);
+    if (timerTracing)
+        timerTraceEnd();
+    return 1;
+}
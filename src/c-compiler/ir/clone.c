@@ -7,11 +7,88 @@
 
 #include "ir.h"
 
+// Types in templates that cloning shared rather than copied, for --stats
+uint32_t cloneTypesShared = 0;
+
+// Whether a type in a template depends on nothing cloning substitutes: no
+// parameter, no 'Self', and no declaration the template itself declares.
+// Such a type is the same type in every copy, and type check marks a type it
+// has checked, so every copy can share the template's node: the first to be
+// checked checks it, and the rest find it checked.
+//
+// What is decided is remembered on the type (and on each part it looks at),
+// so a template's types are marked the first time one is instantiated, and
+// later instances read the marks. Anything but the types listed counts as
+// depending on the template: an expression is lowered in place by the type
+// check of whatever holds it, so it is never shared.
+static int cloneIsShared(INode *type) {
+    if (type->flags & CloneMarked)
+        return type->flags & CloneShared;
+
+    int shared = 1;
+    INode **nodesp;
+    uint32_t cnt;
+    switch (type->tag) {
+    case TypeNameUseTag: {
+        INode *dcl = ((NameUseNode*)type)->dclnode;
+        shared = dcl && ((NameUseNode*)type)->namesym != selfTypeName
+            && isTypeNode(dcl) && dcl->tag != LifetimeTag && genericGetInfo(dcl) == NULL;
+        break;
+    }
+    case PtrTag:
+        shared = cloneIsShared(((StarNode*)type)->vtexp);
+        break;
+    case RefTag:
+    case ArrayRefTag:
+    case VirtRefTag: {
+        RefNode *ref = (RefNode*)type;
+        shared = cloneIsShared(ref->region) && cloneIsShared(ref->perm) && cloneIsShared(ref->vtexp);
+        break;
+    }
+    case ArrayTag:
+        for (nodesFor(((ArrayNode*)type)->dimens, cnt, nodesp)) {
+            if ((*nodesp)->tag != ULitTag)
+                shared = 0;
+        }
+        for (nodesFor(((ArrayNode*)type)->elems, cnt, nodesp))
+            shared = cloneIsShared(*nodesp) && shared;
+        break;
+    case TTupleTag:
+        for (nodesFor(((TupleNode*)type)->elems, cnt, nodesp))
+            shared = cloneIsShared(*nodesp) && shared;
+        break;
+    // Declared once for the whole program, so not marked
+    case UintNbrTag:
+    case IntNbrTag:
+    case FloatNbrTag:
+    case BorrowRegTag:
+        return 1;
+    case VoidTag:
+        break;
+    default:
+        shared = 0;
+    }
+    type->flags |= CloneMarked | (shared ? CloneShared : 0);
+    return shared;
+}
+
 // Deep copy a node
 INode *cloneNode(CloneState *cstate, INode *nodep) {
     if (nodep == NULL)
         return NULL;
 
+    // An interned type is checked and never changes, and it is the one node
+    // for its type, so a copy shares it rather than making another
+    if ((nodep->tag == PtrTag || nodep->tag == ArrayTag || nodep->tag == TTupleTag)
+            && (nodep->flags & InternedType))
+        return nodep;
+
+    // So is a type that nothing cloning substitutes reaches
+    if ((nodep->tag & GroupMask) == TypeGroup && cloneIsShared(nodep)) {
+        ++cloneTypesShared;
+        return nodep;
+    }
+
     INode *node;
     switch (nodep->tag) {
     case AssignTag:
@@ -127,7 +204,7 @@ INode *cloneNode(CloneState *cstate, INode *nodep) {
         // return and no diagnostic that would make the compile's output usable.
         errorExit(ExitError, "Internal error: cloning is not implemented for a node of tag %d", nodep->tag);
     }
-    node->instnode = cstate->instnode;
+    inodeSetInstnode(node, cstate->instnode);
     return node;
 }
 
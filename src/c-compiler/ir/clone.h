@@ -25,6 +25,9 @@ typedef struct CloneDclMap {
     INode *clone;
 } CloneDclMap;
 
+// Types in templates that cloning shared rather than copied, for --stats
+extern uint32_t cloneTypesShared;
+
 // Perform a deep clone of specified node
 INode *cloneNode(CloneState *cstate, INode *nodep);
 
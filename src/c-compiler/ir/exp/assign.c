@@ -23,7 +23,7 @@ AssignNode *newAssignNode(int16_t assigntype, INode *lval, INode *rval) {
 // Clone assign
 INode *cloneAssignNode(CloneState *cstate, AssignNode *node) {
     AssignNode *newnode;
-    newnode = memAllocBlk(sizeof(AssignNode));
+    newnode = memAllocNode(node->tag, sizeof(AssignNode));
     memcpy(newnode, node, sizeof(AssignNode));
     newnode->lval = cloneNode(cstate, node->lval);
     newnode->rval = cloneNode(cstate, node->rval);
@@ -172,6 +172,7 @@ int assignlvalrtype(INode *lval, INode *rtype) {
         // running summary, so only the assignment site itself can carry this.
         if (!(((VarDclNode*)lvalvar)->flowtempflags & VarInitialized))
             lval->flags |= FlagFirstAssign;
+        ((VarDclNode*)lvalvar)->flowflags |= VarAssigned;
         ((VarDclNode*)lvalvar)->flowtempflags |= VarInitialized;
         ((VarDclNode*)lvalvar)->flowtempflags &= 0xFFFF - VarMoved;
     }
@@ -31,7 +31,7 @@ BlockNode *newLoopBlockNode() {
 INode *cloneBlockNode(CloneState *cstate, BlockNode *node) {
     uint32_t dclpos = cloneDclPush();
     BlockNode *newnode;
-    newnode = memAllocBlk(sizeof(BlockNode));
+    newnode = memAllocNode(node->tag, sizeof(BlockNode));
     memcpy(newnode, node, sizeof(BlockNode));
     cloneDclSetMap((INode*)node, (INode*)newnode);  // For fixing cloned break/continue/return nodes
     newnode->stmts = cloneNodes(cstate, node->stmts);
@@ -97,7 +97,7 @@ static void blockContinueStep(NameResState *pstate, BlockNode *blk) {
     // evaluation count because only one of the two copies runs per iteration.
     INode *origstep = nodesLast(target->stmts);
     CloneState cstate;
-    cstate.instnode = origstep->instnode;
+    cstate.instnode = inodeGetInstnode(origstep);
     cstate.selftype = NULL;
     cstate.scope = (uint16_t)pstate->scope;
     nodesInsert(&blk->stmts, cloneNode(&cstate, origstep), pos);
@@ -37,6 +37,7 @@ void borrowMutRef(INode **nodep, INode* type, INode *perm) {
     INode *lvalvar = iexpGetLvalInfo(node, &lvalperm, &scope);
     if (!permMatches(perm, lvalperm))
         errorMsgNode((INode *)node, ErrorBadPerm, "Cannot borrow mutable reference to this.");
+    iexpMarkAddressed(node);
 
     RefNode *reftype = type != unknownType? newRefNodeFull(RefTag, node, borrowRef, perm, type) : (RefNode*)unknownType;
     RefNode *borrownode = newRefNodeFull(BorrowTag, node, borrowRef, perm, node);
@@ -50,6 +51,7 @@ void borrowAuto(INode **from, INode *totypedcl) {
     RefNode *arrreftype = (RefNode*)totypedcl;
     RefNode *addrtype = newRefNodeFull(ArrayRefTag, *from, borrowRef, newPermUseNode(roPerm), arrreftype->vtexp);
     RefNode *borrownode = newRefNode(ArrayBorrowTag);
+    iexpMarkAddressed(*from);
     borrownode->vtype = (INode*)addrtype;
     borrownode->vtexp = *from;
     *from = (INode*)borrownode;
@@ -204,6 +206,7 @@ void borrowTypeCheck(TypeCheckState *pstate, RefNode **nodep) {
         // Set lifetime of reference to borrowed variable's lifetime
         if (lvalvar->tag == VarDclTag)
             scope = ((VarDclNode*)lvalvar)->scope;
+        iexpMarkAddressed(lval);
     }
     INode *lvaltype = ((IExpNode*)lval)->vtype;
 
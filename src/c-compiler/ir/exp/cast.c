@@ -29,7 +29,7 @@ CastNode *newConvCastNode(INode *exp, INode *type) {
 // Clone cast
 INode *cloneCastNode(CloneState *cstate, CastNode *node) {
     CastNode *newnode;
-    newnode = memAllocBlk(sizeof(CastNode));
+    newnode = memAllocNode(node->tag, sizeof(CastNode));
     memcpy(newnode, node, sizeof(CastNode));
     newnode->exp = cloneNode(cstate, node->exp);
     newnode->typ = cloneNode(cstate, node->typ);
@@ -57,7 +57,7 @@ FnCallNode *newFnCallLower(INode *oldnode, INode *obj, int nnodes) {
 // Clone fncall
 INode *cloneFnCallNode(CloneState *cstate, FnCallNode *node) {
     FnCallNode *newnode;
-    newnode = memAllocBlk(sizeof(FnCallNode));
+    newnode = memAllocNode(node->tag, sizeof(FnCallNode));
     memcpy(newnode, node, sizeof(FnCallNode));
     newnode->objfn = cloneNode(cstate, node->objfn);
     if (node->args)
@@ -202,6 +202,7 @@ void fnCallArrIndex(FnCallNode *node) {
     switch (objtype->tag) {
     case ArrayTag:
         node->vtype = arrayElemType(objtype);
+        iexpMarkAddressed(node->objfn);    // an array held by value is indexed in place
         break;
     case RefTag: {
         // Resolve the pointee, exactly as fnCallTypeCheck did when it decided
@@ -715,9 +716,12 @@ void fnCallTypeCheck(TypeCheckState *pstate, FnCallNode **nodep) {
         }
     }
 
-    // A call whose callee names an overload set selects its one viable candidate
+    // A call whose callee names an overload set selects its one viable candidate.
+    // The set is analyzed first, as any declaration a name reaches is, and that
+    // analyzes the candidates whose signatures the selection reads.
     if (node->objfn->tag == VarNameUseTag
         && ((NameUseNode*)node->objfn)->dclnode->tag == FnOverloadDclTag) {
+        inodeTypeCheckAny(pstate, &((NameUseNode*)node->objfn)->dclnode);
         fnCallLowerOverloadFn(node);
         return;
     }
@@ -19,7 +19,7 @@ IfNode *newIfNode() {
 // Clone if
 INode *cloneIfNode(CloneState *cstate, IfNode *node) {
     IfNode *newnode;
-    newnode = memAllocBlk(sizeof(IfNode));
+    newnode = memAllocNode(node->tag, sizeof(IfNode));
     memcpy(newnode, node, sizeof(IfNode));
     newnode->condblk = cloneNodes(cstate, node->condblk);
     return (INode *)newnode;
@@ -18,7 +18,7 @@ NilLitNode *newNilLitNode() {
 // Clone nil node
 INode *cloneNilLitNode(CloneState *cstate, NilLitNode *lit) {
     NilLitNode *newlit;
-    newlit = memAllocBlk(sizeof(NilLitNode));
+    newlit = memAllocNode(lit->tag, sizeof(NilLitNode));
     memcpy(newlit, lit, sizeof(NilLitNode));
     newlit->vtype = cloneNode(cstate, lit->vtype);
     return (INode *)newlit;
@@ -66,7 +66,7 @@ ULitNode *newULitNodeTC(uint64_t nbr, INode *type) {
 // Clone literal
 INode *cloneULitNode(CloneState *cstate, ULitNode *lit) {
     ULitNode *newlit;
-    newlit = memAllocBlk(sizeof(ULitNode));
+    newlit = memAllocNode(lit->tag, sizeof(ULitNode));
     memcpy(newlit, lit, sizeof(ULitNode));
     newlit->vtype = cloneNode(cstate, lit->vtype);
     return (INode *)newlit;
@@ -95,7 +95,7 @@ FLitNode *newFLitNode(double nbr, INode *type) {
 // Clone literal
 INode *cloneFLitNode(CloneState *cstate, FLitNode *lit) {
     FLitNode *newlit;
-    newlit = memAllocBlk(sizeof(FLitNode));
+    newlit = memAllocNode(lit->tag, sizeof(FLitNode));
     memcpy(newlit, lit, sizeof(FLitNode));
     newlit->vtype = cloneNode(cstate, lit->vtype);
     return (INode *)newlit;
@@ -130,7 +130,7 @@ SLitNode *newSLitNode(char *str, uint32_t strlen) {
 // Clone literal
 INode *cloneSLitNode(SLitNode *lit) {
     SLitNode *newlit;
-    newlit = memAllocBlk(sizeof(SLitNode));
+    newlit = memAllocNode(lit->tag, sizeof(SLitNode));
     memcpy(newlit, lit, sizeof(SLitNode));
     return (INode *)newlit;
 }
@@ -18,7 +18,7 @@ LogicNode *newLogicNode(int16_t typ) {
 // Clone logic node
 INode *cloneLogicNode(CloneState *cstate, LogicNode *node) {
     LogicNode *newnode;
-    newnode = memAllocBlk(sizeof(LogicNode));
+    newnode = memAllocNode(node->tag, sizeof(LogicNode));
     memcpy(newnode, node, sizeof(LogicNode));
     newnode->lexp = cloneNode(cstate, node->lexp);
     newnode->rexp = cloneNode(cstate, node->rexp);
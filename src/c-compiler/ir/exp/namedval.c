@@ -19,7 +19,7 @@ NamedValNode *newNamedValNode(INode *name) {
 // Clone namedval
 INode *cloneNamedValNode(CloneState *cstate, NamedValNode *node) {
     NamedValNode *newnode;
-    newnode = memAllocBlk(sizeof(NamedValNode));
+    newnode = memAllocNode(node->tag, sizeof(NamedValNode));
     memcpy(newnode, node, sizeof(NamedValNode));
     newnode->name = cloneNode(cstate, node->name);
     newnode->val = cloneNode(cstate, node->val);
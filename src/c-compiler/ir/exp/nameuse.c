@@ -83,7 +83,7 @@ NameUseNode *newMemberUseNode(Name *namesym) {
 // Clone NameUse
 INode *cloneNameUseNode(CloneState *cstate, NameUseNode *node) {
     NameUseNode *newnode;
-    newnode = memAllocBlk(sizeof(NameUseNode));
+    newnode = memAllocNode(node->tag, sizeof(NameUseNode));
     memcpy(newnode, node, sizeof(NameUseNode));
     newnode->dclnode = cloneDclFix(node->dclnode);
     return (INode *)newnode;
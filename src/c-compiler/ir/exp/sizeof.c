@@ -18,7 +18,7 @@ SizeofNode *newSizeofNode() {
 // Clone sizeof
 INode *cloneSizeofNode(CloneState *cstate, SizeofNode *node) {
     SizeofNode *newnode;
-    newnode = memAllocBlk(sizeof(SizeofNode));
+    newnode = memAllocNode(node->tag, sizeof(SizeofNode));
     memcpy(newnode, node, sizeof(SizeofNode));
     newnode->type = cloneNode(cstate, node->type);
     return (INode *)newnode;
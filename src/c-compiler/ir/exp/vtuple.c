@@ -33,4 +33,6 @@ void vtupleTypeCheck(TypeCheckState *pstate, TupleNode *tuple) {
             continue;
         nodesAdd(&ttuple->elems, ((IExpNode *)*nodesp)->vtype);
     }
+    // Checked as a written tuple type is, which interns it
+    itypeTypeCheck(pstate, &tuple->vtype);
 }
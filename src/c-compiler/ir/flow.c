@@ -68,12 +68,15 @@ void flowInjectAliasNode(INode **nodep) {
 // (e.g., for assignment or function arguments).
 // Does this expression still hold its value after it is read?
 // An lvalue names storage that keeps it; anything else is a temporary.
+// An assignment's value is what its lvalue now holds, so 'a = b = x' leaves
+// two holders of what 'x' handed over.
 int flowIsLvalRead(INode *node) {
     switch (node->tag) {
     case VarNameUseTag:
     case DerefTag:
     case ArrIndexTag:
     case FldAccessTag:
+    case AssignTag:
         return 1;
     default:
         return 0;
@@ -285,6 +288,7 @@ int flowScopeDealias(size_t startpos, Nodes **varlist, INode *retexp) {
                 FnCallNode *dropfncall = newFnCallLower(retexp, dropfn, 1);
                 INode *dropnameuse = (INode*)newNameUseFromDclNode((INode*)avar->node, retexp);
                 INode *borrow = newBorrowMutRef(dropnameuse, ((IExpNode*)avar->node)->vtype, (INode*)uniPerm);
+                avar->node->flowflags |= VarAddressed;
                 nodesAdd(&dropfncall->args, borrow);
                 if (*varlist == NULL)
                     *varlist = newNodes(4);
@@ -257,6 +257,28 @@ int iexpIsLvalError(INode *lval) {
     return 0;
 }
 
+// Mark the variable whose own storage holds lval as having its address taken.
+// Through a dereference the lval is in storage the variable points at, so the
+// variable's own value is only read.
+void iexpMarkAddressed(INode *lval) {
+    while (1) {
+        switch (lval->tag) {
+        case VarNameUseTag: {
+            INode *dclnode = ((NameUseNode *)lval)->dclnode;
+            if (dclnode->tag == VarDclTag)
+                ((VarDclNode *)dclnode)->flowflags |= VarAddressed;
+            return;
+        }
+        case FldAccessTag:
+        case ArrIndexTag:
+            lval = ((FnCallNode *)lval)->objfn;
+            break;
+        default:
+            return;
+        }
+    }
+}
+
 // Extract lval variable, scope and overall permission from lval
 INode *iexpGetLvalInfo(INode *lval, INode **lvalperm, uint16_t *scope) {
     switch (lval->tag) {
@@ -61,6 +61,9 @@ int iexpIsLvalError(INode *lval);
 // Extract lval variable, scope and overall permission from lval
 INode *iexpGetLvalInfo(INode *lval, INode **lvalperm, uint16_t *scope);
 
+// Mark the variable whose own storage holds lval as having its address taken
+void iexpMarkAddressed(INode *lval);
+
 // Are types the same (no coercion)
 int iexpSameType(INode *to, INode **from);
 
@@ -9,6 +9,7 @@
 #include "../parser/lexer.h"
 #include "../shared/fileio.h"
 #include "../shared/error.h"
+#include "../shared/timer.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -17,11 +18,68 @@
 
 // Copy lexer info over
 void inodeLexCopy(INode *new, INode *old) {
-    new->instnode = old->instnode;
-    new->lexer = old->lexer;
-    new->linenbr = old->linenbr;
-    new->linep = old->linep;
-    new->srcp = old->srcp;
+    new->srcloc = old->srcloc;
+    inodeSetInstnode(new, inodeGetInstnode(old));
+}
+
+// What instantiated each cloned node, which only error messages and name
+// mangling ask for. Most nodes are not clones, so rather than every node
+// carrying a pointer for it, it lives in this hash table keyed by node.
+typedef struct {
+    INode *node;
+    INode *instnode;
+} InstnodeEntry;
+
+static InstnodeEntry *instnodeTable = NULL;
+static size_t instnodeAvail = 0;    // Always a power of 2
+static size_t instnodeUsed = 0;
+
+// Nodes are 16-byte aligned, so the low bits say nothing
+#define instnodeHash(node) ((((size_t)(node)) >> 4) * 0x9E3779B97F4A7C15ull)
+
+// Find a node's slot: the one holding it, or the empty one it would go in
+static InstnodeEntry *inodeInstnodeSlot(INode *node) {
+    size_t mask = instnodeAvail - 1;
+    size_t i = (size_t)(instnodeHash(node) >> 20) & mask;
+    while (instnodeTable[i].node && instnodeTable[i].node != node)
+        i = (i + 1) & mask;
+    return &instnodeTable[i];
+}
+
+// The node whose instantiation cloned this one, or NULL if it is not a clone
+INode *inodeGetInstnode(INode *node) {
+    if (instnodeUsed == 0)
+        return NULL;
+    return inodeInstnodeSlot(node)->instnode;
+}
+
+// Record the node whose instantiation cloned this one
+void inodeSetInstnode(INode *node, INode *instnode) {
+    if (instnodeUsed == 0 && instnode == NULL)
+        return;
+
+    // Grow at half full, re-hashing what is there into the new table
+    if (instnodeUsed >= instnodeAvail >> 1) {
+        InstnodeEntry *oldtable = instnodeTable;
+        size_t oldavail = instnodeAvail;
+        instnodeAvail = oldavail ? oldavail << 1 : 1024;
+        instnodeTable = (InstnodeEntry *)memAllocFor(MemNodeCat, instnodeAvail * sizeof(InstnodeEntry));
+        memset(instnodeTable, 0, instnodeAvail * sizeof(InstnodeEntry));
+        for (size_t i = 0; i < oldavail; ++i) {
+            if (oldtable[i].node)
+                *inodeInstnodeSlot(oldtable[i].node) = oldtable[i];
+        }
+        memOrphan(MemNodeCat, oldavail * sizeof(InstnodeEntry));
+    }
+
+    InstnodeEntry *slot = inodeInstnodeSlot(node);
+    if (slot->node == NULL) {
+        if (instnode == NULL)
+            return;
+        slot->node = node;
+        ++instnodeUsed;
+    }
+    slot->instnode = instnode;
 }
 
 // State for inodePrint
@@ -198,6 +256,86 @@ void inodePrint(char *dir, char *srcfn, INode *pgmnode) {
     fclose(irfile);
 }
 
+// The name of a node's tag, for diagnostics
+char *inodeTagName(uint16_t tag) {
+    switch (tag) {
+    case ProgramTag: return "Program";
+    case KeywordTag: return "Keyword";
+    case IntrinsicTag: return "Intrinsic";
+    case ReturnTag: return "Return";
+    case BlockRetTag: return "BlockRet";
+    case BreakTag: return "Break";
+    case ContinueTag: return "Continue";
+    case SwapTag: return "Swap";
+    case ImportTag: return "Import";
+    case NameUseTag: return "NameUse";
+    case TupleTag: return "Tuple";
+    case StarTag: return "Star";
+    case ModuleTag: return "Module";
+    case FnDclTag: return "FnDcl";
+    case FnOverloadDclTag: return "FnOverloadDcl";
+    case VarDclTag: return "VarDcl";
+    case FieldDclTag: return "FieldDcl";
+    case ConstDclTag: return "ConstDcl";
+    case VarNameUseTag: return "VarNameUse";
+    case MbrNameUseTag: return "MbrNameUse";
+    case NilLitTag: return "NilLit";
+    case ULitTag: return "ULit";
+    case FLitTag: return "FLit";
+    case StringLitTag: return "StringLit";
+    case ArrayLitTag: return "ArrayLit";
+    case TypeLitTag: return "TypeLit";
+    case VTupleTag: return "VTuple";
+    case AssignTag: return "Assign";
+    case FnCallTag: return "FnCall";
+    case ArrIndexTag: return "ArrIndex";
+    case FldAccessTag: return "FldAccess";
+    case SizeofTag: return "Sizeof";
+    case CastTag: return "Cast";
+    case BorrowTag: return "Borrow";
+    case ArrayBorrowTag: return "ArrayBorrow";
+    case AllocateTag: return "Allocate";
+    case ArrayAllocTag: return "ArrayAlloc";
+    case DerefTag: return "Deref";
+    case NotLogicTag: return "NotLogic";
+    case OrLogicTag: return "OrLogic";
+    case AndLogicTag: return "AndLogic";
+    case IsTag: return "Is";
+    case BlockTag: return "Block";
+    case IfTag: return "If";
+    case AliasTag: return "Alias";
+    case NamedValTag: return "NamedVal";
+    case AbsenceTag: return "Absence";
+    case TypeNameUseTag: return "TypeNameUse";
+    case TypedefTag: return "Typedef";
+    case FnSigTag: return "FnSig";
+    case ArrayTag: return "Array";
+    case RefTag: return "Ref";
+    case ArrayRefTag: return "ArrayRef";
+    case VirtRefTag: return "VirtRef";
+    case ArrayDerefTag: return "ArrayDeref";
+    case PtrTag: return "Ptr";
+    case TTupleTag: return "TTuple";
+    case VoidTag: return "Void";
+    case QuesTag: return "Ques";
+    case BorrowRegTag: return "BorrowReg";
+    case UnknownTag: return "Unknown";
+    case EnumTag: return "Enum";
+    case LifetimeTag: return "Lifetime";
+    case IntNbrTag: return "IntNbr";
+    case UintNbrTag: return "UintNbr";
+    case FloatNbrTag: return "FloatNbr";
+    case StructTag: return "Struct";
+    case PermTag: return "Perm";
+    case MacroNameTag: return "MacroName";
+    case GenericNameTag: return "GenericName";
+    case GenVarUseTag: return "GenVarUse";
+    case MacroDclTag: return "MacroDcl";
+    case GenVarDclTag: return "GenVarDcl";
+    default: return "?";
+    }
+}
+
 // Dispatch a node walk for the current semantic analysis pass
 // - pstate is helpful state info for node traversal
 // - node is a pointer to pointer so that a node can be replaced
@@ -308,6 +446,7 @@ void inodeNameRes(NameResState *pstate, INode **node) {
 // - node is a pointer to pointer so that a node can be replaced
 // - expectType is the type expected of an expression node (or unknownType/noCareType)
 void inodeTypeCheck(TypeCheckState *pstate, INode **node, INode *expectType) {
+    int traced = 0;
 
     // A declaration is type checked once, however many places reach it. This
     // pass lowers and replaces nodes, so a second walk of one corrupts it; the
@@ -333,6 +472,7 @@ void inodeTypeCheck(TypeCheckState *pstate, INode **node, INode *expectType) {
         if ((*node)->flags & TypeChecking)
             return;
         (*node)->flags |= TypeChecking;
+        traced = timerTracing && isNamedNode(*node);
     }
     else if (inodeIsDcl(*node)) {
         if ((*node)->flags & TypeChecked)
@@ -345,6 +485,16 @@ void inodeTypeCheck(TypeCheckState *pstate, INode **node, INode *expectType) {
         if ((*node)->flags & TypeChecking)
             return;
         (*node)->flags |= TypeChecking;
+        traced = timerTracing && isNamedNode(*node);
+    }
+    // A time trace gives each module and declaration analyzed its own scope.
+    // The program's own module has no name, so its source's stands in.
+    if (traced) {
+        Name *name = inodeGetName(*node);
+        if ((*node)->tag == ModuleTag)
+            timerTraceBegin("TypeCheckModule", name ? &name->namestr : srclocUrl((*node)->srcloc));
+        else
+            timerTraceBegin("TypeCheck", name ? &name->namestr : NULL);
     }
 
     switch ((*node)->tag) {
@@ -458,6 +608,8 @@ void inodeTypeCheck(TypeCheckState *pstate, INode **node, INode *expectType) {
         fnOverloadDclTypeCheck(pstate, (FnOverloadDclNode *)*node); break;
     default:
         errorUnreachable(*node, "a node type check has no case for");
+        if (traced)
+            timerTraceEnd();
         return;
     }
 
@@ -468,6 +620,8 @@ void inodeTypeCheck(TypeCheckState *pstate, INode **node, INode *expectType) {
             || inodeIsDcl(*node)) {
         (*node)->flags |= TypeChecked;
     }
+    if (traced)
+        timerTraceEnd();
 }
 
 
@@ -539,6 +693,29 @@ int inodeIsPrivate(INode *node) {
     return namesym && namesym->namestr == '_';
 }
 
+// Determine whether type check reached a declaration. A generic is reached
+// through its instances, so it counts as reached once it has one, and an
+// overload name through its candidates.
+int inodeIsReached(INode *node) {
+    if (node->tag == FnOverloadDclTag) {
+        INode **nodesp;
+        uint32_t cnt;
+        for (nodesFor(((FnOverloadDclNode*)node)->overloads, cnt, nodesp)) {
+            if (inodeIsReached(*nodesp))
+                return 1;
+        }
+        return 0;
+    }
+    GenericInfo *genericinfo = NULL;
+    if (node->tag == FnDclTag)
+        genericinfo = ((FnDclNode*)node)->genericinfo;
+    else if (node->tag == StructTag)
+        genericinfo = ((StructNode*)node)->genericinfo;
+    if (genericinfo)
+        return genericinfo->memonodes != NULL;
+    return (node->flags & TypeChecked) != 0;
+}
+
 // Determine whether an earlier diagnostic already marked this node as bad.
 // A check that would complain about such a node has nothing new to report.
 int inodeIsError(INode *node) {
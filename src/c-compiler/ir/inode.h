@@ -19,22 +19,16 @@
 #define inode_h
 
 #include "memory.h"
+#include "../shared/srcloc.h"
 
-// All IR nodes begin with this header, mostly containing lexer data describing
-// where in the source this structure came from (useful for error messages)
+// All IR nodes begin with this header, kept small as every node has one
+// - srcloc is where in the source the node's token is (see srcloc.h),
+//   which is decoded for error messages and debug info
 // - tag contains the NodeTags code
 // - flags contains node-specific flags
-// - instnode points to what triggered instancing, if not NULL
-// - lexer contains -> url (filepath) and -> source
-// - srcp points to start of source token
-// - linep points to start of line that token begins on
-// - linenbr is the source file's line number, starting with 1
+// What triggered instancing a cloned node is kept apart: see inodeGetInstnode
 #define INodeHdr \
-    INode *instnode; \
-    Lexer *lexer; \
-    char *srcp; \
-    char *linep; \
-    uint32_t linenbr; \
+    SrcLoc srcloc; \
     uint16_t tag; \
     uint16_t flags
 
@@ -229,6 +223,9 @@ enum NodeTags {
 #define SameSize           0x0020  // An enumtrait, where all implementations are padded to same size
 #define HasTagField        0x0040  // A trait/struct has an enumerated field identifying the variant type
 #define NullablePtr        0x0080  // trait/struct has nullable pointer, generating optimized data
+#define InternedType       0x0100  // The type table's one node for a pointer, array or tuple type
+#define CloneShared        0x0200  // A template's type no parameter reaches, which its copies share
+#define CloneMarked        0x0400  // Cloning has decided CloneShared for this type
 
 // Type check progress, carried by every declaration. These are type check's
 // marks and no other phase's: inodeTypeCheck sets and tests them, and neither
@@ -244,27 +241,26 @@ enum NodeTags {
 
 // Allocate and initialize the INode portion of a new node
 #define newNode(node, nodestruct, nodetype) {\
-    node = (nodestruct*) memAllocBlk(sizeof(nodestruct)); \
+    node = (nodestruct*) memAllocNode(nodetype, sizeof(nodestruct)); \
     node->tag = nodetype; \
     node->flags = 0; \
-    node->instnode = NULL; \
-    node->lexer = lex; \
-    node->srcp = lex->tokp; \
-    node->linep = lex->linep; \
-    node->linenbr = lex->linenbr; \
+    node->srcloc = lex->srcbase + (SrcLoc)(lex->tokp - lex->source); \
 }
 
 // Copy lexer info over to another node
 #define copyNodeLex(newnode, oldnode) { \
-    (newnode)->lexer = (oldnode)->lexer; \
-    (newnode)->srcp = (oldnode)->srcp; \
-    (newnode)->linep = (oldnode)->linep; \
-    (newnode)->linenbr = (oldnode)->linenbr; \
+    (newnode)->srcloc = (oldnode)->srcloc; \
 }
 
 // Copy lexer info over
 void inodeLexCopy(INode *new, INode *old);
 
+// The node whose instantiation cloned this one, or NULL if it is not a clone
+INode *inodeGetInstnode(INode *node);
+
+// Record the node whose instantiation cloned this one
+void inodeSetInstnode(INode *node, INode *instnode);
+
 // Helper functions for serializing a node
 void inodePrint(char *dir, char *srcfn, INode *pgm);
 void inodePrintNode(INode *node);
@@ -274,6 +270,9 @@ void inodePrintIndent();
 void inodePrintIncr();
 void inodePrintDecr();
 
+// The name of a node's tag, for diagnostics
+char *inodeTagName(uint16_t tag);
+
 // Obtain name from a named node
 Name *inodeGetName(INode *node);
 
@@ -281,6 +280,10 @@ Name *inodeGetName(INode *node);
 int inodeIsDcl(INode *node);
 int inodeIsPrivate(INode *node);
 
+// Determine whether type check reached a declaration. A generic is reached
+// through its instances, and an overload name through its candidates.
+int inodeIsReached(INode *node);
+
 // Determine whether an earlier diagnostic already marked this node as bad
 int inodeIsError(INode *node);
 
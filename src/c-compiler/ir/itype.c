@@ -55,12 +55,20 @@ INode *iTypeFindFnField(INode *type, Name *name) {
 }
 
 // Type check node, expecting it to be a type. Give error and return 0, if not.
+// A pointer, array or tuple type that checked clean is then replaced by the
+// one node interned for it, so that equal types are one node. This is done
+// here rather than in inodeTypeCheck so that a type written where a value
+// belongs keeps its own node, and its error its own location.
 int itypeTypeCheck(TypeCheckState *pstate, INode **node) {
+    int errcnt = errors;
     inodeTypeCheckAny(pstate, node);
     if (!isTypeNode(*node)) {
         errorMsgNode(*node, ErrorNotTyped, "Expected a type.");
         return 0;
     }
+    if (((*node)->tag == PtrTag || (*node)->tag == ArrayTag || (*node)->tag == TTupleTag)
+            && !((*node)->flags & InternedType) && errors == errcnt)
+        *node = typetblIntern(*node);
     return 1;
 }
 
@@ -76,6 +84,9 @@ int itypeIsSame(INode *node1, INode *node2) {
         return 1;
     if (node1->tag != node2->tag)
         return 0;
+    // Two interned types are the same only as one node
+    if (node1->flags & node2->flags & InternedType)
+        return 0;
 
     // For non-named types, equality is determined structurally
     // because they specify the same typed parts
@@ -101,7 +112,9 @@ int itypeIsSame(INode *node1, INode *node2) {
     }
 }
 
-// Calculate the hash for a type to use in type table indexing
+// Calculate the hash for a type to use in type table indexing.
+// Types itypeIsSame or itypeIsRunSame finds the same must hash the same, so
+// a structural type hashes its parts, and a named one its declaration.
 size_t itypeHash(INode *node) {
     INode *type = itypeGetTypeDcl(node);
     switch (type->tag) {
@@ -110,6 +123,16 @@ size_t itypeHash(INode *node) {
         return refHash((RefNode*)type);
     case ArrayRefTag:
         return arrayRefHash((RefNode*)type);
+    case PtrTag:
+        return ptrHash((StarNode*)type);
+    case ArrayTag:
+        return arrayHash((ArrayNode*)type);
+    case TTupleTag:
+        return ttupleHash((TupleNode*)type);
+    case FnSigTag:
+        return fnSigHash((FnSigNode*)type);
+    case VoidTag:
+        return 5381 + VoidTag;
     case PermTag:
         return ((size_t)immPerm) >> 3;  // Hash for all static permissions is the same
     default:
@@ -131,6 +154,9 @@ int itypeIsRunSame(INode *node1, INode *node2) {
         return 1;
     if (node1->tag != node2->tag)
         return 0;
+    // Two interned types are the same only as one node
+    if (node1->flags & node2->flags & InternedType)
+        return 0;
 
     // For non-named types, equality is determined structurally
     // because they specify the same typed parts
@@ -285,7 +311,7 @@ static char *itypeMangleNamed(char *bufp, INode *dclnode) {
     strcpy(bufp, &namesym->namestr);
     bufp += strlen(bufp);
 
-    INode *instnode = dclnode->instnode;
+    INode *instnode = inodeGetInstnode(dclnode);
     if (instnode == NULL
         || (instnode->tag != FnCallTag && instnode->tag != TypeLitTag
             && instnode->tag != ArrIndexTag && instnode->tag != FldAccessTag))
@@ -72,6 +72,10 @@ size_t itypeHash(INode *type);
 // Nodes must both be types, but may be name use or declare nodes.
 int itypeIsRunSame(INode *node1, INode *node2);
 
+// Return 1 if two types generate as the same LLVM type: runtime-same, but
+// looking inside function signatures and tuples too (see samecode.c)
+int itypeIsSameCode(INode *type1, INode *type2);
+
 // Is totype equivalent or a subtype of fromtype
 TypeCompare itypeMatches(INode *totype, INode *fromtype, SubtypeConstraint constraint);
 
@@ -6,7 +6,9 @@
 */
 
 #include "../ir.h"
+#include "../../shared/timer.h"
 
+#include <stdio.h>
 #include <string.h>
 #include <assert.h>
 
@@ -15,9 +17,87 @@ GenericInfo *newGenericInfo() {
     GenericInfo *geninfo = (GenericInfo*)memAllocBlk(sizeof(GenericInfo));
     geninfo->parms = NULL;
     geninfo->memonodes = NULL;
+    geninfo->memoindex = NULL;
+    geninfo->memoavail = 0;
     return geninfo;
 }
 
+// How instantiation went, for --stats
+static uint32_t genericReused = 0;      // Uses that found the instance already made
+static uint32_t genericMade = 0;        // Uses that had to make it
+static uint64_t genericCloneTicks = 0;  // Time spent cloning what was made
+static uint32_t genericShared = 0;      // Instances made that share an earlier one's code
+
+// Print how often an instance was made and how often one was reused
+void genericPrintStats() {
+    printf("Generic instances: %u reused, %u made, %u sharing code, %.6g sec cloning, %u types shared\n",
+        genericReused, genericMade, genericShared, (double)genericCloneTicks / timerTick(), cloneTypesShared);
+}
+
+// Hash a generic call's type arguments. Types that itypeIsSame finds the same
+// hash the same, so only calls with an equal hash need comparing.
+static size_t genericArgsHash(FnCallNode *gencall) {
+    size_t hash = 5381;
+    INode **nodesp;
+    uint32_t cnt;
+    for (nodesFor(gencall->args, cnt, nodesp))
+        hash = ((hash << 5) + hash) ^ itypeHash(*nodesp);
+    return hash;
+}
+
+// Return 1 if two generic calls have the same type arguments
+static int genericArgsSame(FnCallNode *call1, FnCallNode *call2) {
+    INode **nodes1p;
+    uint32_t cnt;
+    INode **nodes2p = &nodesGet(call2->args, 0);
+    for (nodesFor(call1->args, cnt, nodes1p)) {
+        if (!itypeIsSame(*nodes1p, *nodes2p++))
+            return 0;
+    }
+    return 1;
+}
+
+// Return 1 if two generic calls have type arguments the same at runtime,
+// which itypeHash also hashes the same
+static int genericArgsRunSame(FnCallNode *call1, FnCallNode *call2) {
+    INode **nodes1p;
+    uint32_t cnt;
+    INode **nodes2p = &nodesGet(call2->args, 0);
+    for (nodesFor(call1->args, cnt, nodes1p)) {
+        if (!itypeIsSameCode(*nodes1p, *nodes2p++))
+            return 0;
+    }
+    return 1;
+}
+
+// Put a call, at index pair in memonodes, in an index with room for it
+static void genericIndexPut(GenericMemo *index, uint32_t avail, size_t hash, uint32_t pair) {
+    size_t slot = hash & (avail - 1);
+    while (index[slot].pair)
+        slot = (slot + 1) & (avail - 1);
+    index[slot].hash = hash;
+    index[slot].pair = pair + 1;
+}
+
+// Index the call just added to memonodes at index pair.
+// The index is doubled whenever it would be more than half full.
+static void genericIndexAdd(GenericInfo *info, size_t hash, uint32_t pair) {
+    uint32_t instances = pair / 2 + 1;
+    if (instances * 2 > info->memoavail) {
+        uint32_t oldavail = info->memoavail;
+        GenericMemo *oldindex = info->memoindex;
+        info->memoavail = oldavail ? oldavail << 1 : 8;
+        info->memoindex = (GenericMemo *)memAllocBlk(info->memoavail * sizeof(GenericMemo));
+        memset(info->memoindex, 0, info->memoavail * sizeof(GenericMemo));
+        for (uint32_t slot = 0; slot < oldavail; ++slot) {
+            if (oldindex[slot].pair)
+                genericIndexPut(info->memoindex, info->memoavail, oldindex[slot].hash, oldindex[slot].pair - 1);
+        }
+        memOrphan(MemOtherCat, oldavail * sizeof(GenericMemo));
+    }
+    genericIndexPut(info->memoindex, info->memoavail, hash, pair);
+}
+
 // Serialize
 void genericInfoPrint(GenericInfo *info) {
     INode **nodesp;
@@ -125,23 +205,58 @@ void genericInstantiateExit() {
     --instantiateDepth;
 }
 
+// Find an earlier, checked instance of a generic function that generates
+// the same code as the one at index pair, and record it as the one to use
+static void genericShareCode(GenericInfo *info, FnCallNode *srcgencall, FnDclNode *instance, uint32_t pair) {
+    if (errors || !(instance->flags & TypeChecked))
+        return;
+    size_t hash = genericArgsHash(srcgencall);
+    size_t mask = info->memoavail - 1;
+    GenericMemo *index = info->memoindex;
+    for (size_t slot = hash & mask; index[slot].pair; slot = (slot + 1) & mask) {
+        uint32_t other = index[slot].pair - 1;
+        if (other >= pair || index[slot].hash != hash)
+            continue;
+        FnDclNode *earlier = (FnDclNode *)nodesGet(info->memonodes, other + 1);
+        if (earlier->runsame == NULL
+            && genericArgsRunSame((FnCallNode *)nodesGet(info->memonodes, other), srcgencall)
+            && fnDclIsSameCode(earlier, instance)) {
+            instance->runsame = earlier;
+            ++genericShared;
+            return;
+        }
+    }
+}
+
 // Instantiate the generic based on parms and return
 INode *genericInstantiate(TypeCheckState *pstate, FnCallNode *srcgencall, INode *nodetoclone,
         GenericInfo *genericinfo, Name *name) {
+    uint64_t cloning = timerGet();
     CloneState cstate;
     clonePushState(&cstate, (INode*)srcgencall, NULL, pstate->scope, genericinfo->parms, srcgencall->args);
     INode *instance = cloneNode(&cstate, nodetoclone);
     clonePopState();
+    genericCloneTicks += timerGet() - cloning;
 
-    // Remember instantiation for the future
+    // Remember instantiation for the future, indexed by its type arguments
     if (!genericinfo->memonodes)
         genericinfo->memonodes = newNodes(2);
+    uint32_t pair = genericinfo->memonodes->used;
     nodesAdd(&genericinfo->memonodes, (INode*)srcgencall);
     nodesAdd(&genericinfo->memonodes, instance);
+    genericIndexAdd(genericinfo, genericArgsHash(srcgencall), pair);
 
     // Type check the instanced declaration
     inodeTypeCheckAny(pstate, &instance);
 
+    // A function instance whose type arguments differ from an earlier one's
+    // only in what the runtime cannot tell apart, such as a reference's
+    // permission, may have come out of type check as the same code. If so, it
+    // is generated as that instance's function rather than as a copy of it.
+    // Those arguments hash the same, so the earlier one is in the same chain.
+    if (instance->tag == FnDclTag)
+        genericShareCode(genericinfo, srcgencall, (FnDclNode*)instance, pair);
+
     return instance;
 }
 
@@ -174,29 +289,21 @@ INode *genericMemoize(TypeCheckState *pstate, FnCallNode *srcgencall, INode *nod
     if (badargs)
         return newErrorNode((INode*)srcgencall);
 
-    if (!genericinfo->memonodes)
-        genericinfo->memonodes = newNodes(2);
-
-    // Check whether these types have already been instantiated for this generic
-    // memonodes holds pairs of nodes: an FnCallNode and what it instantiated
-    // A match is the first FnCallNode whose types match what we want
-    for (nodesFor(genericinfo->memonodes, cnt, nodesp)) {
-        FnCallNode *fncallprior = (FnCallNode *)*nodesp;
-        nodesp++; cnt--; // skip to instance srcgencallp
-        int match = 1;
-        INode **priornodesp;
-        uint32_t priorcnt;
-        INode **nownodesp = &nodesGet(srcgencall->args, 0);
-        for (nodesFor(fncallprior->args, priorcnt, priornodesp)) {
-            if (!itypeIsSame(*priornodesp, *nownodesp)) {
-                match = 0;
-                break;
+    // Check whether these types have already been instantiated for this generic.
+    // memonodes holds pairs of nodes: an FnCallNode and what it instantiated.
+    // Its index finds the call with these type arguments, if there is one,
+    // without comparing the arguments of every other instance along the way.
+    size_t hash = genericArgsHash(srcgencall);
+    if (genericinfo->memoavail) {
+        size_t mask = genericinfo->memoavail - 1;
+        GenericMemo *index = genericinfo->memoindex;
+        for (size_t slot = hash & mask; index[slot].pair; slot = (slot + 1) & mask) {
+            if (index[slot].hash == hash
+                && genericArgsSame((FnCallNode *)nodesGet(genericinfo->memonodes, index[slot].pair - 1), srcgencall)) {
+                // Return a namenode pointing to dcl instance
+                ++genericReused;
+                return newNameUseFromDclNode(nodesGet(genericinfo->memonodes, index[slot].pair), (INode*)srcgencall);
             }
-            nownodesp++;
-        }
-        if (match) {
-            // Return a namenode pointing to dcl instance
-            return newNameUseFromDclNode(*nodesp, (INode*)srcgencall);
         }
     }
 
@@ -205,6 +312,9 @@ INode *genericMemoize(TypeCheckState *pstate, FnCallNode *srcgencall, INode *nod
     // generic again at larger type arguments, so this is where depth is counted.
     if (!genericInstantiateEnter((INode*)srcgencall))
         return newErrorNode((INode*)srcgencall);
+    ++genericMade;
+    if (timerTracing)
+        timerTraceBegin("Instantiate", name ? &name->namestr : NULL);
 
     INode *retinstance;
     // If node is not a tagged-field trait/struct, we can just instantiate it and be done
@@ -228,6 +338,8 @@ INode *genericMemoize(TypeCheckState *pstate, FnCallNode *srcgencall, INode *nod
                 retinstance = instance;
         }
     }
+    if (timerTracing)
+        timerTraceEnd();
     genericInstantiateExit();
 
     return newNameUseFromDclNode(retinstance, (INode*)srcgencall);
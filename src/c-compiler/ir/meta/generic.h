@@ -7,9 +7,17 @@
 #ifndef generic_h
 #define generic_h
 
+// A slot in a generic's index of its instances
+typedef struct GenericMemo {
+    size_t hash;             // Hash of the instance's type arguments
+    uint32_t pair;           // Index of its call in memonodes, plus 1 (0 = empty)
+} GenericMemo;
+
 typedef struct GenericInfo {
     Nodes *parms;            // Declared parameter nodes w/ defaults (GenVarTag)
     Nodes *memonodes;        // Pairs of memoized generic calls and cloned bodies
+    GenericMemo *memoindex;  // Open-addressed index of memonodes' calls, by their type arguments
+    uint32_t memoavail;      // Slots in memoindex (a power of 2, or 0)
 } GenericInfo;
 
 // Create a new generic info block
@@ -39,6 +47,9 @@ GenericInfo *genericGetInfo(INode *node);
 int genericInstantiateEnter(INode *errnode);
 void genericInstantiateExit();
 
+// Print how often an instance was made and how often one was reused, for --stats
+void genericPrintStats();
+
 // Perform generic substitution, if this is a correctly set up generic "fncall"
 // Return 1 if done/error needed. Return 0 if not generic or it leaves behind a lit/fncall that needs processing.
 int genericSubstitute(TypeCheckState *pstate, FnCallNode **nodep);
@@ -49,7 +49,7 @@ void namespaceGrow(Namespace *namespace) {
     // Allocate and initialize new name table
     oldTable = namespace->namenodes;
     newTblMem = namespace->avail * sizeof(NameNode);
-    namespace->namenodes = (NameNode*)memAllocBlk(newTblMem);
+    namespace->namenodes = (NameNode*)memAllocFor(MemNamespaceCat, newTblMem);
     memset(namespace->namenodes, 0, newTblMem);
 
     // Copy existing name slots to re-hashed positions in new table
@@ -62,7 +62,7 @@ void namespaceGrow(Namespace *namespace) {
             newslotp->node = oldslotp->node;
         }
     }
-    // memFreeBlk(oldTable);
+    memOrphan(MemNamespaceCat, oldTblAvail * sizeof(NameNode));
 }
 
 // Initialize a namespace with a specific number of slots
@@ -83,7 +83,7 @@ void nametblGrow() {
     gNameTblAvail = oldTblAvail==0? gNameTblInitSize : oldTblAvail<<1;
     gNameTblCeil = (gNameTblUtil * gNameTblAvail) / 100;
     newTblMem = gNameTblAvail * sizeof(Name*);
-    gNameTable = (Name**) memAllocBlk(newTblMem);
+    gNameTable = (Name**) memAllocFor(MemNameTblCat, newTblMem);
     memset(gNameTable, 0, newTblMem); // Fill with NULL pointers & 0s
 
     // Copy existing name slots to re-hashed positions in new table
@@ -101,7 +101,7 @@ void nametblGrow() {
             *newslotp = *oldslotp;
         }
     }
-    // memFreeBlk(oldTable);
+    memOrphan(MemNameTblCat, oldTblAvail * sizeof(Name*));
 }
 
 /** Get pointer to interned Name in Global Name Table matching string. 
@@ -124,7 +124,7 @@ Name *nametblFind(char *strp, size_t strl) {
         }
 
         // Allocate and populate name info
-        *slotp = newname = memAllocBlk(sizeof(Name) + strl);
+        *slotp = newname = memAllocFor(MemNameTblCat, sizeof(Name) + strl);
         memcpy(&newname->namestr, strp, strl);
         (&newname->namestr)[strl] = '\0';
         newname->hash = hash;
@@ -250,7 +250,7 @@ void nametblHookPush() {
     // Ensure we have a large enough area for HookTable pointers
     if (gHookTableSize == 0) {
         gHookTableSize = 32;
-        gHookTables = (HookTable*)memAllocBlk(gHookTableSize * sizeof(HookTable));
+        gHookTables = (HookTable*)memAllocFor(MemNameTblCat, gHookTableSize * sizeof(HookTable));
         memset(gHookTables, 0, gHookTableSize * sizeof(HookTable));
         gHookTablePos = 0;
     }
@@ -259,9 +259,10 @@ void nametblHookPush() {
         HookTable *oldtable = gHookTables;
         int oldsize = gHookTableSize;
         gHookTableSize <<= 1;
-        gHookTables = (HookTable*)memAllocBlk(gHookTableSize * sizeof(HookTable));
+        gHookTables = (HookTable*)memAllocFor(MemNameTblCat, gHookTableSize * sizeof(HookTable));
         memset(gHookTables, 0, gHookTableSize * sizeof(HookTable));
         memcpy(gHookTables, oldtable, oldsize * sizeof(HookTable));
+        memOrphan(MemNameTblCat, oldsize * sizeof(HookTable));
     }
 
     HookTable *table = &gHookTables[gHookTablePos];
@@ -269,7 +270,7 @@ void nametblHookPush() {
     // Allocate a new HookTable, if we don't have one allocated yet
     if (table->alloc == 0) {
         table->alloc = gHookTablePos == 0 ? 128 : 32;
-        table->hooktbl = (HookTableEntry *)memAllocBlk(table->alloc * sizeof(HookTableEntry));
+        table->hooktbl = (HookTableEntry *)memAllocFor(MemNameTblCat, table->alloc * sizeof(HookTableEntry));
         memset(table->hooktbl, 0, table->alloc * sizeof(HookTableEntry));
     }
     // Let's re-use the one we have
@@ -283,9 +284,10 @@ void nametblHookGrow() {
     HookTableEntry *oldtable = tablemeta->hooktbl;
     int oldsize = tablemeta->alloc;
     tablemeta->alloc <<= 1;
-    tablemeta->hooktbl = (HookTableEntry *)memAllocBlk(tablemeta->alloc * sizeof(HookTableEntry));
+    tablemeta->hooktbl = (HookTableEntry *)memAllocFor(MemNameTblCat, tablemeta->alloc * sizeof(HookTableEntry));
     memset(tablemeta->hooktbl, 0, tablemeta->alloc * sizeof(HookTableEntry));
     memcpy(tablemeta->hooktbl, oldtable, oldsize * sizeof(HookTableEntry));
+    memOrphan(MemNameTblCat, oldsize * sizeof(HookTableEntry));
 }
 
 // Hook a name + node in the current hooktable
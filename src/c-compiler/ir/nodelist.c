@@ -15,15 +15,16 @@
 void nodelistInit(NodeList *mnodes, uint32_t size) {
     mnodes->avail = size;
     mnodes->used = 0;
-    mnodes->nodes = (INode **)memAllocBlk(size * sizeof(INode **));
+    mnodes->nodes = (INode **)memAllocFor(MemNodesCat, size * sizeof(INode **));
 }
 
 // Double size, if full
 void nodelistGrow(NodeList *mnodes) {
     INode **oldnodes;
     oldnodes = mnodes->nodes;
+    memOrphan(MemNodesCat, mnodes->avail * sizeof(INode **));
     mnodes->avail <<= 1;
-    mnodes->nodes = (INode **)memAllocBlk(mnodes->avail * sizeof(INode **));
+    mnodes->nodes = (INode **)memAllocFor(MemNodesCat, mnodes->avail * sizeof(INode **));
     memcpy(mnodes->nodes, oldnodes, mnodes->used * sizeof(INode **));
 }
 
@@ -64,7 +65,9 @@ void nodelistMakeSpace(NodeList *nodes, size_t pos, int32_t amt) {
         while (nodes->used + amt >= newsize)
             newsize <<= 1;
         INode **oldnodes = nodes->nodes;
-        nodes->nodes = memAllocBlk(newsize);
+        nodes->nodes = memAllocFor(MemNodesCat, newsize * sizeof(INode*));
+        memOrphan(MemNodesCat, nodes->avail * sizeof(INode*));
+        nodes->avail = newsize;
         memcpy(nodes->nodes, oldnodes, (nodes->used) * sizeof(INode*));
     }
 
@@ -16,7 +16,7 @@
 // Allocate and initialize a new nodes block
 Nodes *newNodes(int size) {
     Nodes *nodes;
-    nodes = (Nodes*) memAllocBlk(sizeof(Nodes) + size*sizeof(INode*));
+    nodes = (Nodes*) memAllocFor(MemNodesCat, sizeof(Nodes) + size*sizeof(INode*));
     nodes->avail = size;
     nodes->used = 0;
     return nodes;
@@ -47,6 +47,7 @@ void nodesAdd(Nodes **nodesp, INode *node) {
         op = (INode **)(oldnodes+1);
         np = (INode **)(nodes+1);
         memcpy(np, op, (nodes->used = oldnodes->used) * sizeof(INode*));
+        memOrphan(MemNodesCat, sizeof(Nodes) + oldnodes->avail*sizeof(INode*));
         *nodesp = nodes;
     }
     *((INode**)(nodes+1)+nodes->used) = node;
@@ -66,6 +67,7 @@ void nodesInsert(Nodes **nodesp, INode *node, size_t index) {
         op = (INode **)(oldnodes + 1);
         np = (INode **)(nodes + 1);
         memcpy(np, op, (nodes->used = oldnodes->used) * sizeof(INode*));
+        memOrphan(MemNodesCat, sizeof(Nodes) + oldnodes->avail*sizeof(INode*));
         *nodesp = nodes;
     }
     op = (INode **)(nodes + 1) + index;
@@ -114,6 +116,7 @@ void nodesMakeSpace(Nodes **nodesp, size_t pos, int32_t amt) {
         op = (INode **)(oldnodes + 1);
         np = (INode **)(nodes + 1);
         memcpy(np, op, (nodes->used = oldnodes->used) * sizeof(INode*));
+        memOrphan(MemNodesCat, sizeof(Nodes) + oldnodes->avail*sizeof(INode*));
         *nodesp = nodes;
     }
 
@@ -0,0 +1,261 @@
+/** Whether two function bodies generate the same code
+ * @file
+ *
+ * Two instances of one generic whose type arguments differ only where the
+ * runtime cannot tell -- '&mut T', '&ro T' and '&uni T' are one pointer --
+ * are cloned and checked separately, and usually come out of type check as
+ * the same tree but for those permissions. Generating both would emit the
+ * same machine code twice over, under two names. These functions answer
+ * whether that is so, so that generation can give the later instance the
+ * earlier one's function instead (see genericInstantiate).
+ *
+ * The walk runs after both bodies are type checked and flow analyzed, so
+ * what it compares is exactly what generation would read: every node's tag
+ * and flags, every expression's type up to runtime sameness, and every name
+ * use's declaration. A declaration local to the bodies -- a parameter, a
+ * local, a block a break leaves -- is paired with its counterpart as the walk
+ * reaches it, using the clone pass's declaration map, and a use matches when
+ * it names the pair. Anything it does not know how to compare is different,
+ * so that a node kind added later can only cost a missed fold.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "ir.h"
+
+#include <string.h>
+
+// Return 1 if two types generate as the same LLVM type.
+// A function signature or tuple is compared by its parts, so that one whose
+// parts are only runtime-same is too; anything else is itypeIsRunSame.
+int itypeIsSameCode(INode *type1, INode *type2) {
+    if (type1 == NULL || type2 == NULL)
+        return type1 == type2;
+    type1 = itypeGetTypeDcl(type1);
+    type2 = itypeGetTypeDcl(type2);
+    if (type1 == type2)
+        return 1;
+    if (type1->tag != type2->tag)
+        return 0;
+
+    INode **nodes1p, **nodes2p;
+    uint32_t cnt;
+    switch (type1->tag) {
+    case FnSigTag: {
+        FnSigNode *sig1 = (FnSigNode*)type1;
+        FnSigNode *sig2 = (FnSigNode*)type2;
+        if (!itypeIsSameCode(sig1->rettype, sig2->rettype) || sig1->parms->used != sig2->parms->used)
+            return 0;
+        nodes2p = &nodesGet(sig2->parms, 0);
+        for (nodesFor(sig1->parms, cnt, nodes1p)) {
+            if (!itypeIsSameCode(((IExpNode*)*nodes1p)->vtype, ((IExpNode*)*nodes2p++)->vtype))
+                return 0;
+        }
+        return 1;
+    }
+    case TTupleTag: {
+        TupleNode *tuple1 = (TupleNode*)type1;
+        TupleNode *tuple2 = (TupleNode*)type2;
+        if (tuple1->elems->used != tuple2->elems->used)
+            return 0;
+        nodes2p = &nodesGet(tuple2->elems, 0);
+        for (nodesFor(tuple1->elems, cnt, nodes1p)) {
+            if (!itypeIsSameCode(*nodes1p, *nodes2p++))
+                return 0;
+        }
+        return 1;
+    }
+    default:
+        return itypeIsRunSame(type1, type2);
+    }
+}
+
+static int sameCode(INode *node1, INode *node2);
+
+static int sameCodeNodes(Nodes *nodes1, Nodes *nodes2) {
+    if (nodes1 == NULL || nodes2 == NULL)
+        return nodes1 == nodes2;
+    if (nodes1->used != nodes2->used)
+        return 0;
+    INode **nodes1p;
+    uint32_t cnt;
+    INode **nodes2p = &nodesGet(nodes2, 0);
+    for (nodesFor(nodes1, cnt, nodes1p)) {
+        if (!sameCode(*nodes1p, *nodes2p++))
+            return 0;
+    }
+    return 1;
+}
+
+// The declaration generation uses for one a name use names: an instance
+// already found to share another's code is that other
+static INode *sameCodeDcl(INode *dcl) {
+    while (dcl && dcl->tag == FnDclTag && ((FnDclNode*)dcl)->runsame)
+        dcl = (INode*)((FnDclNode*)dcl)->runsame;
+    return dcl;
+}
+
+// Compare two variable declarations, pairing them if they match
+static int sameCodeVar(VarDclNode *var1, VarDclNode *var2) {
+    if (!itypeIsSameCode(var1->vtype, var2->vtype) || !itypeIsSame(var1->perm, var2->perm)
+        || var1->scope != var2->scope || var1->index != var2->index
+        || var1->flowflags != var2->flowflags || !sameCode(var1->value, var2->value))
+        return 0;
+    cloneDclSetMap((INode*)var1, (INode*)var2);
+    return 1;
+}
+
+static int sameCode(INode *node1, INode *node2) {
+    if (node1 == NULL || node2 == NULL)
+        return node1 == node2;
+    if (isTypeNode(node1) || isTypeNode(node2))
+        return isTypeNode(node1) && isTypeNode(node2) && itypeIsSameCode(node1, node2);
+    if (node1->tag != node2->tag || node1->flags != node2->flags)
+        return 0;
+    if (isExpNode(node1) && !itypeIsSameCode(((IExpNode*)node1)->vtype, ((IExpNode*)node2)->vtype))
+        return 0;
+
+    switch (node1->tag) {
+    case VarDclTag:
+        return sameCodeVar((VarDclNode*)node1, (VarDclNode*)node2);
+
+    case VarNameUseTag:
+    case MbrNameUseTag:
+        return sameCodeDcl(cloneDclFix(((NameUseNode*)node1)->dclnode))
+            == sameCodeDcl(((NameUseNode*)node2)->dclnode);
+
+    // A block is paired before its statements, for the breaks among them
+    case BlockTag: {
+        BlockNode *blk1 = (BlockNode*)node1;
+        BlockNode *blk2 = (BlockNode*)node2;
+        if (blk1->lifesym != blk2->lifesym
+            || (blk1->breaks ? blk1->breaks->used : 0) != (blk2->breaks ? blk2->breaks->used : 0))
+            return 0;
+        cloneDclSetMap(node1, node2);
+        return sameCodeNodes(blk1->stmts, blk2->stmts);
+    }
+
+    case IfTag:
+        return sameCodeNodes(((IfNode*)node1)->condblk, ((IfNode*)node2)->condblk);
+
+    case BreakTag:
+    case ContinueTag:
+    case BlockRetTag:
+    case ReturnTag: {
+        BreakRetNode *brk1 = (BreakRetNode*)node1;
+        BreakRetNode *brk2 = (BreakRetNode*)node2;
+        return cloneDclFix((INode*)brk1->block) == (INode*)brk2->block
+            && sameCode(brk1->exp, brk2->exp) && sameCode(brk1->life, brk2->life)
+            && sameCodeNodes(brk1->dealias, brk2->dealias);
+    }
+
+    case AssignTag:
+        return ((AssignNode*)node1)->assignType == ((AssignNode*)node2)->assignType
+            && sameCode(((AssignNode*)node1)->lval, ((AssignNode*)node2)->lval)
+            && sameCode(((AssignNode*)node1)->rval, ((AssignNode*)node2)->rval);
+    case SwapTag:
+        return sameCode(((SwapNode*)node1)->lval, ((SwapNode*)node2)->lval)
+            && sameCode(((SwapNode*)node1)->rval, ((SwapNode*)node2)->rval);
+
+    case FnCallTag:
+    case ArrIndexTag:
+    case FldAccessTag:
+    case TypeLitTag:
+        return sameCode(((FnCallNode*)node1)->objfn, ((FnCallNode*)node2)->objfn)
+            && sameCode(((FnCallNode*)node1)->methfld, ((FnCallNode*)node2)->methfld)
+            && sameCodeNodes(((FnCallNode*)node1)->args, ((FnCallNode*)node2)->args);
+
+    case CastTag:
+    case IsTag:
+        return itypeIsSameCode(((CastNode*)node1)->typ, ((CastNode*)node2)->typ)
+            && sameCode(((CastNode*)node1)->exp, ((CastNode*)node2)->exp);
+
+    case DerefTag:
+        return sameCode(((StarNode*)node1)->vtexp, ((StarNode*)node2)->vtexp);
+
+    case BorrowTag:
+    case ArrayBorrowTag:
+    case AllocateTag:
+    case ArrayAllocTag: {
+        RefNode *ref1 = (RefNode*)node1;
+        RefNode *ref2 = (RefNode*)node2;
+        return ref1->scope == ref2->scope
+            && itypeIsSameCode(ref1->perm, ref2->perm) && itypeIsSameCode(ref1->region, ref2->region)
+            && sameCode(ref1->vtexp, ref2->vtexp);
+    }
+
+    case NotLogicTag:
+    case OrLogicTag:
+    case AndLogicTag:
+        return sameCode(((LogicNode*)node1)->lexp, ((LogicNode*)node2)->lexp)
+            && sameCode(((LogicNode*)node1)->rexp, ((LogicNode*)node2)->rexp);
+
+    case NamedValTag:
+        return sameCode(((NamedValNode*)node1)->name, ((NamedValNode*)node2)->name)
+            && sameCode(((NamedValNode*)node1)->val, ((NamedValNode*)node2)->val);
+
+    case AliasTag: {
+        AliasNode *alias1 = (AliasNode*)node1;
+        AliasNode *alias2 = (AliasNode*)node2;
+        if (alias1->aliasamt != alias2->aliasamt || (alias1->counts == NULL) != (alias2->counts == NULL))
+            return 0;
+        if (alias1->counts && memcmp(alias1->counts, alias2->counts, alias1->aliasamt * sizeof(int16_t)) != 0)
+            return 0;
+        return sameCode(alias1->exp, alias2->exp);
+    }
+
+    case SizeofTag:
+        return itypeIsSameCode(((SizeofNode*)node1)->type, ((SizeofNode*)node2)->type);
+
+    case VTupleTag:
+        return sameCodeNodes(((TupleNode*)node1)->elems, ((TupleNode*)node2)->elems);
+    case ArrayLitTag:
+        return sameCodeNodes(((ArrayNode*)node1)->dimens, ((ArrayNode*)node2)->dimens)
+            && sameCodeNodes(((ArrayNode*)node1)->elems, ((ArrayNode*)node2)->elems);
+
+    case NilLitTag:
+        return 1;
+    case ULitTag:
+        return ((ULitNode*)node1)->uintlit == ((ULitNode*)node2)->uintlit;
+    case FLitTag:
+        return memcmp(&((FLitNode*)node1)->floatlit, &((FLitNode*)node2)->floatlit, sizeof(double)) == 0;
+    case StringLitTag:
+        return ((SLitNode*)node1)->strlen == ((SLitNode*)node2)->strlen
+            && memcmp(((SLitNode*)node1)->strlit, ((SLitNode*)node2)->strlit, ((SLitNode*)node1)->strlen) == 0;
+
+    default:
+        return 0;
+    }
+}
+
+// Return 1 if two checked functions generate the same code, but for their names.
+// A function that names itself matches one that names itself.
+int fnDclIsSameCode(FnDclNode *fn1, FnDclNode *fn2) {
+    if (!(fn1->flags & TypeChecked) || !(fn2->flags & TypeChecked) || fn1->flags != fn2->flags
+        || (fn1->flags & FlagInline) || fn1->clones || fn2->clones
+        || fn1->value == NULL || fn2->value == NULL || fn1->value->tag != BlockTag)
+        return 0;
+    FnSigNode *sig1 = (FnSigNode*)itypeGetTypeDcl(fn1->vtype);
+    FnSigNode *sig2 = (FnSigNode*)itypeGetTypeDcl(fn2->vtype);
+    if (sig1->tag != FnSigTag || sig2->tag != FnSigTag
+        || !itypeIsSameCode(sig1->rettype, sig2->rettype) || sig1->parms->used != sig2->parms->used)
+        return 0;
+
+    uint32_t dclpos = cloneDclPush();
+    cloneDclSetMap((INode*)fn1, (INode*)fn2);
+    int same = 1;
+    INode **parms1p;
+    uint32_t cnt;
+    INode **parms2p = &nodesGet(sig2->parms, 0);
+    for (nodesFor(sig1->parms, cnt, parms1p)) {
+        if (!sameCodeVar((VarDclNode*)*parms1p, (VarDclNode*)*parms2p++)) {
+            same = 0;
+            break;
+        }
+    }
+    if (same)
+        same = sameCode(fn1->value, fn2->value);
+    cloneDclPop(dclpos);
+    return same;
+}
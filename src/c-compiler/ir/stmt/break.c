@@ -21,7 +21,7 @@ BreakRetNode *newBreakNode() {
 // Clone break
 INode *cloneBreakNode(CloneState *cstate, BreakRetNode *node) {
     BreakRetNode *newnode;
-    newnode = memAllocBlk(sizeof(BreakRetNode));
+    newnode = memAllocNode(node->tag, sizeof(BreakRetNode));
     memcpy(newnode, node, sizeof(BreakRetNode));
     newnode->exp = cloneNode(cstate, node->exp);
     newnode->block = (BlockNode *)cloneDclFix((INode*)node->block);
@@ -19,7 +19,7 @@ BreakRetNode *newContinueNode() {
 // Clone continue
 INode *cloneContinueNode(CloneState *cstate, BreakRetNode *node) {
     BreakRetNode *newnode;
-    newnode = memAllocBlk(sizeof(BreakRetNode));
+    newnode = memAllocNode(node->tag, sizeof(BreakRetNode));
     memcpy(newnode, node, sizeof(BreakRetNode));
     newnode->block = (BlockNode *)cloneDclFix((INode*)node->block);
     return (INode *)newnode;
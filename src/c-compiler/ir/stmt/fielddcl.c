@@ -24,7 +24,7 @@ FieldDclNode *newFieldDclNode(Name *namesym, INode *perm) {
 
 // Create a new field node that is a copy of an existing one
 INode *cloneFieldDclNode(CloneState *cstate, FieldDclNode *node) {
-    FieldDclNode *newnode = memAllocBlk(sizeof(FieldDclNode));
+    FieldDclNode *newnode = memAllocNode(node->tag, sizeof(FieldDclNode));
     memcpy(newnode, node, sizeof(FieldDclNode));
     // A clone is unchecked however far along the node it was copied from got.
     // memcpy carries the type check marks with everything else, and a clone that
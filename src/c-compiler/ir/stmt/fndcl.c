@@ -22,6 +22,8 @@ FnDclNode *newFnDclNode(Name *namesym, uint16_t flags, INode *type, INode *val)
     node->llvmvar = NULL;
     node->genname = namesym? &namesym->namestr : "";
     node->genericinfo = NULL;
+    node->clones = NULL;
+    node->runsame = NULL;
     return node;
 }
 
@@ -45,25 +47,68 @@ void fnOverloadDclAdd(FnOverloadDclNode *ovlnode, FnDclNode *fnnode) {
 // Return a clone of a function/method declaration
 INode *cloneFnDclNode(CloneState *cstate, FnDclNode *oldfn) {
     uint32_t dclpos = cloneDclPush();
-    FnDclNode *newnode = memAllocBlk(sizeof(FnDclNode));
+    FnDclNode *newnode = memAllocNode(oldfn->tag, sizeof(FnDclNode));
     memcpy(newnode, oldfn, sizeof(FnDclNode));
     // A clone is unchecked however far along the node it was copied from got.
     // memcpy carries the type check marks with everything else, and a clone that
     // kept them would be skipped by the guard in inodeTypeCheck.
     newnode->flags &= 0xffff - (TypeChecked | TypeChecking);
     newnode->genericinfo = NULL;
+    newnode->runsame = NULL;
     newnode->vtype = cloneNode(cstate, oldfn->vtype);
     newnode->value = cloneNode(cstate, oldfn->value);
     cloneDclPop(dclpos);
     return (INode*)newnode;
 }
 
+// A feature's index here is its bit in the mask conestd's coneCpuFeatures returns
+// at run time, so the two lists change together. They run oldest to newest,
+// which is what ranks one version above another when the CPU could run both.
+char *fnCloneFeatures[] = {
+    "sse4.2", "popcnt", "avx", "bmi", "bmi2", "fma", "avx2",
+    "avx512f", "avx512cd", "avx512dq", "avx512bw", "avx512vl", NULL
+};
+
+// Return the mask of fnCloneFeatures a '@target_clones' version requires
+int32_t fnCloneMask(char *spec, uint32_t len) {
+    if (len == 7 && strncmp(spec, "default", 7) == 0)
+        return 0;
+    int32_t mask = 0;
+    char *end = spec + len;
+    while (spec < end) {
+        char *plus = memchr(spec, '+', end - spec);
+        size_t featlen = (plus? plus : end) - spec;
+        int32_t bit = 0;
+        while (fnCloneFeatures[bit]
+            && (strlen(fnCloneFeatures[bit]) != featlen || strncmp(fnCloneFeatures[bit], spec, featlen) != 0))
+            ++bit;
+        if (fnCloneFeatures[bit] == NULL)
+            return -1;
+        mask |= 1 << bit;
+        spec += featlen + (plus? 1 : 0);
+        if (plus && spec == end)
+            return -1;    // a trailing '+' names nothing
+    }
+    return mask? mask : -1;
+}
+
 // Serialize a function node
 void fnDclPrint(FnDclNode *node) {
     if (node->namesym)
         inodeFprint("fn %s", &node->namesym->namestr);
     else
         inodeFprint("fn");
+    if (node->clones) {
+        INode **nodesp;
+        uint32_t cnt;
+        inodeFprint(" @target_clones(");
+        for (nodesFor(node->clones, cnt, nodesp)) {
+            inodePrintNode(*nodesp);
+            if (cnt > 1)
+                inodeFprint(", ");
+        }
+        inodeFprint(")");
+    }
     if (node->genericinfo)
         genericInfoPrint(node->genericinfo);
     if (node->overloadsym)
@@ -146,11 +191,58 @@ void fnImplicitReturn(INode *rettype, BlockNode *blk) {
     }
 }
 
+// Check a '@target_clones' attribute: what it is on, and each feature set it lists.
+// Generation makes one version of the body per set and chooses between them when
+// the program loads, so every set must be one the runtime can test for, no two
+// may be the same, and one must be the "default" for a CPU with none of them.
+static void fnDclClonesCheck(FnDclNode *fnnode) {
+    if (fnnode->genericinfo) {
+        errorMsgNode((INode*)fnnode, ErrorBadClones, "A generic function may not be multiversioned with '@target_clones'");
+        return;
+    }
+    if (!fnnode->value || (fnnode->flags & FlagInline)) {
+        errorMsgNode((INode*)fnnode, ErrorBadClones,
+            "'@target_clones' needs a body to version and a symbol to call it through, which an inline or unimplemented function lacks");
+        return;
+    }
+
+    int hasdefault = 0;
+    uint32_t index = 0;
+    INode **nodesp;
+    uint32_t cnt;
+    for (nodesFor(fnnode->clones, cnt, nodesp)) {
+        SLitNode *spec = (SLitNode *)*nodesp;
+        int32_t mask = fnCloneMask(spec->strlit, spec->strlen);
+        if (mask < 0)
+            errorMsgNode(*nodesp, ErrorBadClones,
+                "\"%.*s\" is not a '+'-separated list of features '@target_clones' can test for",
+                (int)spec->strlen, spec->strlit);
+        else {
+            hasdefault |= mask == 0;
+            for (uint32_t prior = 0; prior < index; ++prior) {
+                SLitNode *earlier = (SLitNode *)nodesGet(fnnode->clones, prior);
+                if (fnCloneMask(earlier->strlit, earlier->strlen) == mask) {
+                    errorMsgNode(*nodesp, ErrorBadClones,
+                        "\"%.*s\" requires the same features as an earlier version", (int)spec->strlen, spec->strlit);
+                    break;
+                }
+            }
+        }
+        ++index;
+    }
+    if (!hasdefault)
+        errorMsgNode((INode*)fnnode, ErrorBadClones,
+            "'@target_clones' must list a \"default\" version, for a CPU with none of the others' features");
+}
+
 // Type checking a function's logic does more than you might think:
 // - Turn implicit returns into explicit returns
 // - Perform type checking for all statements
 // - Perform data flow analysis on variables and references
 void fnDclTypeCheck(TypeCheckState *pstate, FnDclNode *fnnode) {
+    if (fnnode->clones)
+        fnDclClonesCheck(fnnode);
+
     // Wait until a generic function is instantiated before type checking
     if (fnnode->genericinfo)
         return;
@@ -214,13 +306,14 @@ void fnDclTypeCheck(TypeCheckState *pstate, FnDclNode *fnnode) {
 }
 
 // Verify no two candidates of an overload set accept the same parameter signature.
-// Candidates are not walked, as each is separately name resolved and type checked
-// by the module or type that owns its concrete declaration.
+// Each candidate is analyzed first, since a call through the overload name reads
+// every one's signature. One its owner already analyzed returns at once.
 void fnOverloadDclTypeCheck(TypeCheckState *pstate, FnOverloadDclNode *node) {
     INode **nodesp;
     uint32_t cnt;
     uint32_t index = 0;
     for (nodesFor(node->overloads, cnt, nodesp)) {
+        inodeTypeCheckAny(pstate, nodesp);
         FnDclNode *candidate = (FnDclNode *)*nodesp;
         for (uint32_t prior = 0; prior < index; ++prior) {
             FnDclNode *earlier = (FnDclNode *)nodesGet(node->overloads, prior);
@@ -16,9 +16,21 @@ typedef struct FnDclNode {
     LLVMValueRef llvmvar;         // LLVM's handle for a declared variable (for generation)
     char *genname;                // Name of the function as known to the linker
     GenericInfo *genericinfo;     // Link to generic parms, etc (or NULL if not generic)
+    Nodes *clones;                // '@target_clones' feature sets, as string literals (or NULL)
+    struct FnDclNode *runsame;    // Earlier instance of its generic whose code is also this one's (or NULL)
     uint16_t vtblidx;             // Method ptr's index in the type's vtable
 } FnDclNode;
 
+// The CPU features a '@target_clones' version may require, by LLVM's names
+extern char *fnCloneFeatures[];
+
+// Return the mask of fnCloneFeatures a '@target_clones' version requires:
+// 0 for "default", and -1 for anything but '+'-separated feature names
+int32_t fnCloneMask(char *spec, uint32_t len);
+
+// Return 1 if two checked functions generate the same code, but for their names
+int fnDclIsSameCode(FnDclNode *fn1, FnDclNode *fn2);
+
 // Overloaded function/method declaration node.
 // It is the namespace binding for an explicitly declared overload name.
 // It has no type, value, or generated symbol: every executable implementation
@@ -97,7 +97,7 @@ void modPrint(ModuleNode *mod) {
     if (mod->namesym)
         inodeFprint("module %s\n", &mod->namesym->namestr);
     else
-        inodeFprint("IR for program %s\n", mod->lexer->url);
+        inodeFprint("IR for program %s\n", srclocUrl(mod->srcloc));
     inodePrintIncr();
     for (nodesFor(mod->nodes, cnt, nodesp)) {
         inodePrintIndent();
@@ -163,6 +163,12 @@ void modTypeCheck(TypeCheckState *pstate, ModuleNode *mod) {
     //
     // Order still does not decide what is analyzed, only when: this loop reaches
     // every declaration, and one already analyzed by demand returns at once.
+    //
+    // A module that is imported, not generated, is not iterated at all. What
+    // is reached from a generated module is analyzed by demand, and the rest
+    // is not reachable from any code there is to generate.
+    if (!(mod->flags & FlagGenMod))
+        return;
     for (nodesFor(mod->nodes, cnt, nodesp)) {
         inodeTypeCheckAny(pstate, nodesp);
     }
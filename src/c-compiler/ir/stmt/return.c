@@ -28,7 +28,7 @@ BreakRetNode *newReturnNodeExp(INode *exp) {
 // Clone return
 INode *cloneReturnNode(CloneState *cstate, BreakRetNode *node) {
     BreakRetNode *newnode;
-    newnode = memAllocBlk(sizeof(BreakRetNode));
+    newnode = memAllocNode(node->tag, sizeof(BreakRetNode));
     memcpy(newnode, node, sizeof(BreakRetNode));
     newnode->exp = cloneNode(cstate, node->exp);
     newnode->block = (BlockNode *)cloneDclFix((INode*)node->block);
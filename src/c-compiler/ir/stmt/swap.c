@@ -21,7 +21,7 @@ SwapNode *newSwapNode(INode *lval, INode *rval) {
 // Clone swap node
 INode *cloneSwapNode(CloneState *cstate, SwapNode *node) {
     SwapNode *newnode;
-    newnode = memAllocBlk(sizeof(SwapNode));
+    newnode = memAllocNode(node->tag, sizeof(SwapNode));
     memcpy(newnode, node, sizeof(SwapNode));
     newnode->lval = cloneNode(cstate, node->lval);
     newnode->rval = cloneNode(cstate, node->rval);
@@ -46,7 +46,7 @@ VarDclNode *newVarDclFull(Name *namesym, uint16_t tag, INode *type, INode *perm,
 
 // Create a new variable dcl node that is a copy of an existing one
 INode *cloneVarDclNode(CloneState *cstate, VarDclNode *node) {
-    VarDclNode *newnode = memAllocBlk(sizeof(VarDclNode));
+    VarDclNode *newnode = memAllocNode(node->tag, sizeof(VarDclNode));
     memcpy(newnode, node, sizeof(VarDclNode));
     // A clone is unchecked however far along the node it was copied from got.
     // memcpy carries the type check marks with everything else, and a clone that
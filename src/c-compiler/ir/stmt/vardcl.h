@@ -26,6 +26,14 @@ enum VarFlowTemp {
     VarMoved = 0x0002           // Variable has been moved
 };
 
+// What type check and flow learn about a variable over its whole scope.
+// A local or parameter with neither, whose permission does not let it be
+// written, is generated as an SSA value rather than given storage.
+enum VarFlowPerm {
+    VarAddressed = 0x0001,      // Its own storage is borrowed or indexed in place
+    VarAssigned = 0x0002        // It is assigned after its declaration
+};
+
 VarDclNode *newVarDclNode(Name *namesym, uint16_t tag, INode *perm);
 VarDclNode *newVarDclFull(Name *namesym, uint16_t tag, INode *sig, INode *perm, INode *val);
 
@@ -44,7 +44,7 @@ uint64_t arrayDim1(INode *array) {
 
 // Clone array
 INode *cloneArrayNode(CloneState *cstate, ArrayNode *node) {
-    ArrayNode *newnode = memAllocBlk(sizeof(ArrayNode));
+    ArrayNode *newnode = memAllocNode(node->tag, sizeof(ArrayNode));
     memcpy(newnode, node, sizeof(ArrayNode));
     newnode->elems = cloneNodes(cstate, node->elems);
     return (INode *)newnode;
@@ -143,6 +143,14 @@ int arrayEqual(ArrayNode *node1, ArrayNode *node2) {
     return 1;
 }
 
+// Calculate hash for a structural array type, agreeing with arrayEqual.
+// Only the count of dimensions is hashed: arrayEqual compares their sizes
+// as literals, which a dimension need not be yet when it is hashed.
+size_t arrayHash(ArrayNode *node) {
+    size_t hash = 5381 + node->tag + node->dimens->used;
+    return ((hash << 5) + hash) ^ itypeHash(arrayElemType((INode*)node));
+}
+
 // Is from-type a subtype of to-struct (we know they are not the same)
 TypeCompare arrayMatches(ArrayNode *to, ArrayNode *from, SubtypeConstraint constraint) {
     // Must have same dimensions
@@ -40,6 +40,9 @@ void arrayTypeCheck(TypeCheckState *pstate, ArrayNode *name);
 
 int arrayEqual(ArrayNode *node1, ArrayNode *node2);
 
+// Calculate hash for a structural array type
+size_t arrayHash(ArrayNode *node);
+
 // Is from-type a subtype of to-struct (we know they are not the same)
 TypeCompare arrayMatches(ArrayNode *to, ArrayNode *from, SubtypeConstraint constraint);
 
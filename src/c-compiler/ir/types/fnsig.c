@@ -20,7 +20,7 @@ FnSigNode *newFnSigNode() {
 
 // Clone function signature
 INode *cloneFnSigNode(CloneState *cstate, FnSigNode *node) {
-    FnSigNode *newnode = memAllocBlk(sizeof(FnSigNode));
+    FnSigNode *newnode = memAllocNode(node->tag, sizeof(FnSigNode));
     memcpy(newnode, node, sizeof(FnSigNode));
     newnode->parms = cloneNodes(cstate, node->parms);
     newnode->rettype = cloneNode(cstate, node->rettype);
@@ -91,6 +91,18 @@ int fnSigEqual(FnSigNode *node1, FnSigNode *node2) {
     return 1;
 }
 
+// Calculate hash for a function signature, agreeing with fnSigEqual: its
+// return type and its parameters' types
+size_t fnSigHash(FnSigNode *node) {
+    size_t hash = 5381 + node->tag;
+    hash = ((hash << 5) + hash) ^ itypeHash(node->rettype);
+    INode **nodesp;
+    uint32_t cnt;
+    for (nodesFor(node->parms, cnt, nodesp))
+        hash = ((hash << 5) + hash) ^ itypeHash(iexpGetTypeDcl(*nodesp));
+    return hash;
+}
+
 // For virtual reference structural matches on two methods,
 // compare two function signatures to see if they are equivalent,
 // ignoring the first 'self' parameter (we know their types differ)
@@ -29,6 +29,8 @@ void fnSigPrint(FnSigNode *node);
 void fnSigNameRes(NameResState *pstate, FnSigNode *sig);
 void fnSigTypeCheck(TypeCheckState *pstate, FnSigNode *name);
 int fnSigEqual(FnSigNode *node1, FnSigNode *node2);
+// Calculate hash for a function signature, agreeing with fnSigEqual
+size_t fnSigHash(FnSigNode *node);
 
 // For virtual reference structural matches on two methods,
 // compare two function signatures to see if they are equivalent,
@@ -21,7 +21,7 @@ LifetimeNode *newLifetimeDclNode(Name *namesym, Lifetime life) {
 
 // Create a copy of lifetime dcl
 INode *cloneLifetimeDclNode(CloneState *cstate, LifetimeNode *node) {
-    LifetimeNode *newnode = memAllocBlk(sizeof(LifetimeNode));
+    LifetimeNode *newnode = memAllocNode(node->tag, sizeof(LifetimeNode));
     memcpy(newnode, node, sizeof(LifetimeNode));
     newnode->life = cstate->scope;
     cloneDclSetMap((INode*)node, (INode*)newnode);
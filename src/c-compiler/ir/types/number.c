@@ -9,7 +9,7 @@
 
 // Clone number node
 INode *cloneNbrNode(CloneState *cstate, NbrNode *node) {
-    NbrNode *newnode = memAllocBlk(sizeof(NbrNode));
+    NbrNode *newnode = memAllocNode(node->tag, sizeof(NbrNode));
     memcpy(newnode, node, sizeof(NbrNode));
     return (INode *)newnode;
 }
@@ -18,7 +18,7 @@ StarNode *newStarNode(uint16_t tag) {
 
 // Clone ptr or deref node
 INode *cloneStarNode(CloneState *cstate, StarNode *node) {
-    StarNode *newnode = memAllocBlk(sizeof(StarNode));
+    StarNode *newnode = memAllocNode(node->tag, sizeof(StarNode));
     memcpy(newnode, node, sizeof(StarNode));
     newnode->vtexp = cloneNode(cstate, node->vtexp);
     return (INode *)newnode;
@@ -47,6 +47,12 @@ int ptrEqual(StarNode *node1, StarNode *node2) {
     return itypeIsSame(node1->vtexp, node2->vtexp);
 }
 
+// Calculate hash for a structural pointer type, agreeing with ptrEqual
+size_t ptrHash(StarNode *node) {
+    size_t hash = 5381 + node->tag;
+    return ((hash << 5) + hash) ^ itypeHash(node->vtexp);
+}
+
 // Will from pointer coerce to a to pointer
 TypeCompare ptrMatches(StarNode *to, StarNode *from, SubtypeConstraint constraint) {
     // Since pointers support both read and write permissions, value type invariance is expected
@@ -32,6 +32,9 @@ void ptrTypeCheck(TypeCheckState *pstate, StarNode *name);
 // Compare two pointer signatures to see if they are equivalent
 int ptrEqual(StarNode *node1, StarNode *node2);
 
+// Calculate hash for a structural pointer type
+size_t ptrHash(StarNode *node);
+
 // Will from pointer coerce to a to pointer (we know they are not the same)
 TypeCompare ptrMatches(StarNode *to, StarNode *from, SubtypeConstraint constraint);
 
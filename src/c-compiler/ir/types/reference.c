@@ -34,7 +34,7 @@ void *refTypeInfoAlloc() {
 
 // Clone reference
 INode *cloneRefNode(CloneState *cstate, RefNode *node) {
-    RefNode *newnode = memAllocBlk(sizeof(RefNode));
+    RefNode *newnode = memAllocNode(node->tag, sizeof(RefNode));
     memcpy(newnode, node, sizeof(RefNode));
     newnode->region = cloneNode(cstate, node->region);
     newnode->perm = cloneNode(cstate, node->perm);
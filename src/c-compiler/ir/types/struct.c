@@ -28,7 +28,7 @@ StructNode *newStructNode(Name *namesym) {
 
 // Clone struct
 INode *cloneStructNode(CloneState *cstate, StructNode *node) {
-    StructNode *newnode = memAllocBlk(sizeof(StructNode));
+    StructNode *newnode = memAllocNode(node->tag, sizeof(StructNode));
     memcpy(newnode, node, sizeof(StructNode));
     newnode->genericinfo = NULL;
     newnode->flags &= 0xffff - (TypeChecked | TypeChecking);
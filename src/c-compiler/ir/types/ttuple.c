@@ -18,7 +18,7 @@ TupleNode *newTupleNode(int cnt) {
 // Clone tuple
 INode *cloneTupleNode(CloneState *cstate, TupleNode *node) {
     TupleNode *newnode;
-    newnode = memAllocBlk(sizeof(TupleNode));
+    newnode = memAllocNode(node->tag, sizeof(TupleNode));
     memcpy(newnode, node, sizeof(TupleNode));
     newnode->elems = cloneNodes(cstate, node->elems);
     return (INode *)newnode;
@@ -80,3 +80,13 @@ int ttupleEqual(TupleNode *totype, TupleNode *fromtype) {
             return 0;
     return 1;
 }
+
+// Calculate hash for a structural tuple type, agreeing with ttupleEqual
+size_t ttupleHash(TupleNode *node) {
+    size_t hash = 5381 + node->tag;
+    INode **nodesp;
+    uint32_t cnt;
+    for (nodesFor(node->elems, cnt, nodesp))
+        hash = ((hash << 5) + hash) ^ itypeHash(*nodesp);
+    return hash;
+}
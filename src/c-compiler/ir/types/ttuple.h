@@ -33,4 +33,7 @@ void ttupleTypeCheck(TypeCheckState *pstate, TupleNode *node);
 // Compare that two tuples are equivalent
 int ttupleEqual(TupleNode *totype, TupleNode *fromtype);
 
+// Calculate hash for a structural tuple type
+size_t ttupleHash(TupleNode *node);
+
 #endif
@@ -20,6 +20,8 @@ static TypeTblEntry *gTypeTable = NULL;    // The type table array
 static size_t gTypeTblAvail = 0;           // Number of allocated type table slots (power of 2)
 static size_t gTypeTblCeil = 0;            // Ceiling that triggers table growth
 static size_t gTypeTblUsed = 0;            // Number of type table slots used
+static uint32_t gTypeTblInterned = 0;      // Structural types interned
+static uint32_t gTypeTblShared = 0;        // Type nodes replaced by one already interned
 
 /** Modulo operation that calculates primary table entry from name's hash.
  * 'size' is always a power of 2 */
@@ -55,7 +57,7 @@ void typetblGrow() {
     gTypeTblAvail = oldTblAvail==0? gTypeTblInitSize : oldTblAvail<<1;
     gTypeTblCeil = (gTypeTblUtil * gTypeTblAvail) / 100;
     newTblMem = gTypeTblAvail * sizeof(TypeTblEntry);
-    gTypeTable = (TypeTblEntry*) memAllocBlk(newTblMem);
+    gTypeTable = (TypeTblEntry*) memAllocFor(MemTypeTblCat, newTblMem);
     memset(gTypeTable, 0, newTblMem); // Fill with NULL pointers & 0s
 
     // Copy existing name slots to re-hashed positions in new table
@@ -71,7 +73,7 @@ void typetblGrow() {
             newslotp->normal = oldslotp->normal;
         }
     }
-    // memFreeBlk(oldTable);
+    memOrphan(MemTypeTblCat, oldTblAvail * sizeof(TypeTblEntry));
 }
 
 /** Get pointer to type's normalized metadata in Global Type Table matching type. 
@@ -99,6 +101,41 @@ void *typetblFind(INode *type, void *(*allocfn)()) {
     return slotp->normal;
 }
 
+/** Get the one interned node for a checked pointer, array or tuple type.
+ * For these, itypeIsRunSame is itypeIsSame, so the table's key is exactly type
+ * equality and two interned nodes are the same type only if they are one node.
+ * The first node checked for a type becomes its interned node. An array whose
+ * element type is still being checked is not interned, because it has not
+ * taken the element's move and thread flags yet. */
+INode *typetblIntern(INode *type) {
+    if (type->tag == ArrayTag && !(itypeGetTypeDcl(arrayElemType(type))->flags & TypeChecked))
+        return type;
+
+    TypeTblEntry *slotp;
+    size_t hash = itypeHash(type);
+    typetblFindSlot(slotp, hash, type);
+    if (slotp->type) {
+        ++gTypeTblShared;
+        return slotp->type;
+    }
+    if (++gTypeTblUsed >= gTypeTblCeil) {
+        typetblGrow();
+        typetblFindSlot(slotp, hash, type);
+    }
+    slotp->type = type;
+    slotp->hash = hash;
+    slotp->normal = NULL;
+    type->flags |= InternedType;
+    ((ITypeNode*)type)->llvmtype = NULL;
+    ++gTypeTblInterned;
+    return type;
+}
+
+// Print how many structural types were interned, and how many nodes they replaced
+void typetblPrintStats() {
+    printf("Structural types: %u interned, %u duplicates replaced\n", gTypeTblInterned, gTypeTblShared);
+}
+
 // Return size of unused space for name table
 size_t typetblUnused() {
     return (gTypeTblAvail-gTypeTblUsed)*sizeof(TypeTblEntry);
@@ -40,6 +40,13 @@ void typetblInit();
 // For an unknown type, it allocates memory for the metadata and adds it to type table.
 void *typetblFind(INode *type, void *(*allocfn)());
 
+// Return the one interned node for a checked pointer, array or tuple type,
+// interning this one if it is the first
+INode *typetblIntern(INode *type);
+
+// Print how many structural types were interned, and how many nodes they replaced
+void typetblPrintStats();
+
 // Return how many bytes have been allocated for global type table but not yet used
 size_t typetblUnused();
 
@@ -16,6 +16,7 @@
 #include "../shared/memory.h"
 #include "../shared/timer.h"
 #include "../shared/utf8.h"
+#include "../shared/bytescan.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -29,13 +30,9 @@ Lexer *lex = NULL;        // Current lexer
 void lexInject(char *src, char *url) {
     Lexer *prev;
 
-    // Every injected source gets its own block, never a recycled one. A block
-    // outlives parsing: each IR node stores the Lexer that was current when it
-    // was built and reads ->url from it whenever a diagnostic is reported, and
-    // conec.c reads ->fname off the program node to name its output files. So
-    // re-using a popped block rewrote the url out from under every node still
-    // pointing at it, and a diagnostic against an earlier module named a later
-    // module's file while echoing the earlier one's source line.
+    // Every injected source gets its own block, never a recycled one, as
+    // lexers are linked to the ones injected before and after them.
+    // A node's location is kept apart, in srcloc.c.
     prev = lex;
     lex = (Lexer*) memAllocBlk(sizeof(Lexer));
     if (prev)
@@ -51,6 +48,7 @@ void lexInject(char *src, char *url) {
     lex->url = url;
     lex->fname = fileName(url);
     lex->source = src;
+    lex->srcbase = srclocAdd(url, src);
 
     // Initialize lexer context
     lex->srcp = lex->tokp = lex->linep = src;
@@ -65,6 +63,22 @@ void lexInject(char *src, char *url) {
     lex->blkStack[0].paranscnt = 0;
     lex->blkStack[0].blkmode = FreeFormBlock;
 
+    // The lexer assumes UTF-8, and reads a source that is not as the bytes it
+    // is. Where it is not, say so once, at the first byte that is not.
+    char *badp = utf8Invalid(src);
+    if (badp) {
+        for (char *srcp = src; srcp < badp; ++srcp) {
+            if (*srcp == '\n') {
+                lex->linep = srcp + 1;
+                ++lex->linenbr;
+            }
+        }
+        lex->tokp = badp;
+        errorMsgLex(WarnEncoding, "This is not valid UTF-8, which a Cone source must be. Only the first such byte is reported.");
+        lex->tokp = lex->linep = src;
+        lex->linenbr = 1;
+    }
+
     // Prime the pump with the first token
     lexNextToken();
 }
@@ -74,7 +88,7 @@ Name *keyAdd(char *keyword, uint16_t toktype) {
     Name *sym;
     INode *node;
     sym = nametblFind(keyword, strlen(keyword));
-    sym->node = node = (INode*)memAllocBlk(sizeof(INode));
+    sym->node = node = (INode*)memAllocNode(KeywordTag, sizeof(INode));
     node->tag = KeywordTag;
     node->flags = toktype;
     return sym;
@@ -95,6 +109,7 @@ void keywordInit() {
     keyAdd("union", UnionToken);
     keyAdd("@move", MoveToken);
     keyAdd("@opaque", OpaqueToken);
+    keyAdd("@target_clones", TargetClonesToken);
     keyAdd("extends", ExtendsToken);
     keyAdd("mixin", MixinToken);
     keyAdd("enum", EnumToken);
@@ -259,8 +274,14 @@ char *lexNewLine(char *srcp) {
     lex->linep = srcp;
     lex->tokPosInLine = 0;
     ++lex->linenbr;
-    // Count line's indentation
+    // Count line's indentation. Most lines are indented with only the
+    // character the source began with, and that run is counted at once.
     lex->curindent = 0;
+    if (lex->indentch == ' ' || lex->indentch == '\t') {
+        char *indentp = bytescanPast(srcp, lex->indentch);
+        lex->curindent = (int)(indentp - srcp);
+        srcp = indentp;
+    }
     while (1) {
         if (*srcp == '\r')
             srcp++;
@@ -399,15 +420,14 @@ void lexScanString(char *srcp) {
     lex->tokp = srcp++;
 
     // Conservatively count the size of the string
-    uint32_t srclen = 0;
-    while (*srcp && *srcp != '"') {
-        srclen++;
-        srcp++;
-        if (*srcp == '\\' && *(srcp + 1) == '"') {
-            srclen++;
-            srcp += 2;
-        }
+    char *endp = srcp;
+    while (1) {
+        endp = bytescanFind(endp, '"', '\\', '"');
+        if (*endp != '\\')
+            break;
+        endp += *(endp + 1) == '"' ? 2 : 1;
     }
+    uint32_t srclen = (uint32_t)(endp - srcp);
 
     // Build string literal
     char *newp = memAllocStr(NULL, srclen);
@@ -425,10 +445,14 @@ void lexScanString(char *srcp) {
             continue;
         }
 
-        // Copy over next byte or an escaped character
+        // Copy over the bytes up to the next escaped or control character,
+        // or an escaped character
         if (*srcp != '\\') {
-            *newp++ = *srcp++; // Works for utf8-encoded characters as well
-            srclen++;
+            char *runp = bytescanFindStringEnd(srcp); // Works for utf8-encoded characters as well
+            memcpy(newp, srcp, runp - srcp);
+            newp += runp - srcp;
+            srclen += (uint32_t)(runp - srcp);
+            srcp = runp;
         }
         else {
             // Handle escaped character(s), including unicode
@@ -601,66 +625,44 @@ void lexScanIdent(char *srcp) {
     lex->tokp = srcbeg;
     srcp += utf8ByteSkip(srcp);  // Skip past already accepted first character
     while (1) {
-        switch (*srcp) {
-
-        // Allow digit, letter or underscore in token
-        case '0': case '1': case '2': case '3': case '4':
-        case '5': case '6': case '7': case '8': case '9':
-        case 'a': case 'b': case 'c': case 'd': case 'e':
-        case 'f': case 'g': case 'h': case 'i': case 'j':
-        case 'k': case 'l': case 'm': case 'n': case 'o':
-        case 'p': case 'q': case 'r': case 's': case 't':
-        case 'u': case 'v': case 'w': case 'x': case 'y': case 'z':
-        case 'A': case 'B': case 'C': case 'D': case 'E':
-        case 'F': case 'G': case 'H': case 'I': case 'J':
-        case 'K': case 'L': case 'M': case 'N': case 'O':
-        case 'P': case 'Q': case 'R': case 'S': case 'T':
-        case 'U': case 'V': case 'W': case 'X': case 'Y': case 'Z':
-        case '_':
-            srcp++;
+        // Allow digit, letter or underscore in token, and unicode letters too
+        srcp = bytescanPastIdent(srcp);
+        if (!utf8IsLetter(srcp))
             break;
+        srcp += utf8ByteSkip(srcp);
+    }
 
-        default:
-            // Allow unicode letters in identifier name
-            if (utf8IsLetter(srcp)) {
-                srcp += utf8ByteSkip(srcp);
-            }
-            else {
-                INode *identNode;
-                // Find identifier token in name table and preserve info about it
-                // Substitute token type when identifier is a keyword
-                lex->val.ident = nametblFind(srcbeg, srcp-srcbeg);
-                identNode = (INode*)lex->val.ident->node;
-                if (identNode && identNode->tag == KeywordTag) {
-                    lex->toktype = identNode->flags;
-                    // A reserved word has no syntax to parse. Report it where it
-                    // was written, then release the name so the rest of the
-                    // compile treats it as the ordinary identifier the author
-                    // meant. Releasing it also reports each reserved word once,
-                    // at its first appearance, rather than at every use.
-                    if (lex->toktype == ReservedToken) {
-                        lex->srcp = srcp;
-                        errorMsgLex(ErrorReserved,
-                            "'%s' is reserved for a language feature that is not implemented yet. Rename it.",
-                            &lex->val.ident->namestr);
-                        lex->val.ident->node = NULL;
-                        lex->toktype = IdentToken;
-                        return;
-                    }
-                }
-                else if (identNode && identNode->tag == PermTag)
-                    lex->toktype = PermToken;
-                else if (*srcbeg == '@')
-                    lex->toktype = AttrIdentToken;
-                else if (*srcbeg == '#')
-                    lex->toktype = MetaIdentToken;
-                else
-                    lex->toktype = IdentToken;
-                lex->srcp = srcp;
-                return;
-            }
+    INode *identNode;
+    // Find identifier token in name table and preserve info about it
+    // Substitute token type when identifier is a keyword
+    lex->val.ident = nametblFind(srcbeg, srcp-srcbeg);
+    identNode = (INode*)lex->val.ident->node;
+    if (identNode && identNode->tag == KeywordTag) {
+        lex->toktype = identNode->flags;
+        // A reserved word has no syntax to parse. Report it where it
+        // was written, then release the name so the rest of the
+        // compile treats it as the ordinary identifier the author
+        // meant. Releasing it also reports each reserved word once,
+        // at its first appearance, rather than at every use.
+        if (lex->toktype == ReservedToken) {
+            lex->srcp = srcp;
+            errorMsgLex(ErrorReserved,
+                "'%s' is reserved for a language feature that is not implemented yet. Rename it.",
+                &lex->val.ident->namestr);
+            lex->val.ident->node = NULL;
+            lex->toktype = IdentToken;
+            return;
         }
     }
+    else if (identNode && identNode->tag == PermTag)
+        lex->toktype = PermToken;
+    else if (*srcbeg == '@')
+        lex->toktype = AttrIdentToken;
+    else if (*srcbeg == '#')
+        lex->toktype = MetaIdentToken;
+    else
+        lex->toktype = IdentToken;
+    lex->srcp = srcp;
 }
 
 /** Tokenize an identifier or reserved token */
@@ -669,8 +671,7 @@ void lexScanTickedIdent(char *srcp) {
     lex->tokp = srcbeg;
 
     // Look for closing backtick, but not past end of line
-    while (*srcp != '`' && *srcp && *srcp != '\n' && *srcp != '\x1a')
-        srcp++;
+    srcp = bytescanFind(srcp, '`', '\n', '\x1a');
     if (*srcp != '`') {
         errorMsgLex(ErrorBadTok, "Back-ticked identifier requires closing backtick");
         srcp = srcbeg + 2;
@@ -686,6 +687,8 @@ void lexScanTickedIdent(char *srcp) {
 char *lexBlockComment(char *srcp) {
     int nest = 1;
     while (*srcp) {
+        // Only these bytes can end, nest or hide the end of the comment
+        srcp = bytescanFind(srcp, '*', '/', '"');
         if (*srcp == '*' && *(srcp + 1) == '/') {
             if (--nest == 0)
                 return srcp+2;
@@ -697,18 +700,23 @@ char *lexBlockComment(char *srcp) {
         }
         // ignore tokens inside line comment
         else if (*srcp == '/' && *(srcp + 1) == '/') {
-            srcp += 2;
-            while (*srcp && *srcp++ != '\n');
+            srcp = bytescanFind(srcp + 2, '\n', '\n', '\n');
+            if (*srcp)
+                ++srcp;
         }
         // ignore tokens inside string literal
         else if (*srcp == '"') {
             ++srcp;
-            while (*srcp && *srcp++ != '"') {
-                if (*(srcp - 1) == '\\' && *srcp == '"')
-                    srcp++;
-            }
+            while (1) {
+                srcp = bytescanFind(srcp, '"', '\\', '"');
+                if (*srcp != '\\')
+                    break;
+                srcp += *(srcp + 1) == '"' ? 2 : 1;
+            }
+            if (*srcp)
+                ++srcp;
         }
-        else
+        else if (*srcp)
             ++srcp;
     }
     return srcp;
@@ -944,9 +952,7 @@ void lexNextTokenx() {
         case '/':
             // Line comment: '//'
             if (*(srcp+1)=='/') {
-                srcp += 2;
-                while (*srcp && *srcp!='\n' && *srcp!='\x1a')
-                    srcp++;
+                srcp = bytescanFind(srcp + 2, '\n', '\x1a', '\n');
             }
             // Block comment, nested: '/*'
             else if (*(srcp + 1) == '*') {
@@ -962,7 +968,7 @@ void lexNextTokenx() {
 
         // Ignore white space
         case ' ': case '\t':
-            srcp++;
+            srcp = bytescanPastBlanks(srcp + 1);
             break;
 
         // Ignore carriage return
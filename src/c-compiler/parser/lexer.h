@@ -12,6 +12,7 @@ typedef struct INode INode;    // ../ast/ast.h
 typedef struct Name Name;    // ../ast/nametbl.h
 
 #include "../coneopts.h"
+#include "../shared/srcloc.h"
 #include <stdint.h>
 
 #define LEX_MAX_BLOCKS 1024
@@ -46,6 +47,7 @@ typedef struct Lexer {
     char *url;        // The url where the source text came from
     char *fname;    // The filename of the url (no extension)
     char *source;    // The source text (0-terminated)
+    SrcLoc srcbase;  // Location of the source's first byte
 
     struct Lexer *next;    // Next lexer (linked list of injected lexers)
     struct Lexer *prev; // Previous lexer
@@ -152,6 +154,7 @@ enum TokenTypes {
     UnionToken,    // 'union'
     MoveToken,     // '@move'
     OpaqueToken,   // '@opaque'
+    TargetClonesToken, // '@target_clones'
     ExtendsToken,  // 'extends'
     MixinToken,    // 'mixin'
     EnumToken,     // 'enum'
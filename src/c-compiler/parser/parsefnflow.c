@@ -484,13 +484,61 @@ MacroDclNode *parseMacro(ParseState *parse) {
     return macro;
 }
 
+// Parse the parenthesized feature sets of a '@target_clones' attribute,
+// one string literal each. What they name is checked with the declaration.
+static Nodes *parseTargetClones() {
+    Nodes *clones = newNodes(4);
+    lexNextToken();
+    if (!lexIsToken(LParenToken)) {
+        errorMsgLex(ErrorBadClones, "Expected '(' and the feature sets to version the function for");
+        return clones;
+    }
+    lexNextToken();
+    lexIncrParens();
+    while (lexIsToken(StringLitToken)) {
+        nodesAdd(&clones, (INode*)newSLitNode(lex->val.strlit, lex->strlen));
+        lexNextToken();
+        if (!lexIsToken(CommaToken))
+            break;
+        lexNextToken();
+    }
+    if (!lexIsToken(RParenToken)) {
+        errorMsgLex(ErrorBadClones, "Each feature set '@target_clones' lists must be a string literal");
+        while (!lexIsToken(RParenToken) && !lexIsToken(EofToken)
+            && !lexIsToken(SemiToken) && !lexIsToken(LCurlyToken))
+            lexNextToken();
+        if (!lexIsToken(RParenToken)) {
+            lexDecrParens();
+            return clones;
+        }
+    }
+    lexNextToken();
+    lexDecrParens();
+    return clones;
+}
+
 // Parse a function block
+// Whether a function's body is expanded wherever it is used, rather than
+// called: a generic or inline function, a trait's method (which implementers
+// inherit), a generic type's method, one with clones, or a body embedded in
+// another declaration. An importer of the function's module needs that body.
+int parseFnIsExpanded(ParseState *parse, FnDclNode *fnnode, uint16_t mayflags) {
+    if (fnnode->genericinfo || (fnnode->flags & FlagInline) || fnnode->clones || (mayflags & ParseEmbedded))
+        return 1;
+    INsTypeNode *type = parse->typenode;
+    return type && (type->tag != StructTag || (type->flags & TraitType) || ((StructNode *)type)->genericinfo);
+}
+
 INode *parseFn(ParseState *parse, uint16_t mayflags) {
     FnDclNode *fnnode = newFnDclNode(NULL, 0, NULL, NULL);
 
     // Skip past the 'fn'.
     lexNextToken();
 
+    // Handle attributes
+    if (lexIsToken(TargetClonesToken))
+        fnnode->clones = parseTargetClones();
+
     // Process function name, if provided
     if (lexIsToken(IdentToken)) {
         if (!(mayflags&ParseMayName))
@@ -542,10 +590,19 @@ INode *parseFn(ParseState *parse, uint16_t mayflags) {
         lexNextToken();
     }
 
-    // Process statements block that implements function, if provided
+    // Process statements block that implements function, if provided.
+    // A module that is imported, not generated, only needs the bodies it
+    // expands where it is used. Which those are is decided here, as the body
+    // is reached, not when something first uses it: a body that may be
+    // expanded is parsed in full whether or not the program ever does, and
+    // the rest are skipped for good and never parsed.
     if (parseHasBlock()) {
         if (!(mayflags&ParseMayImpl))
             errorMsgNode((INode*)fnnode, ErrorBadImpl, "Function/method implementation is not allowed here.");
+        if (!(parse->mod->flags & FlagGenMod) && !parseFnIsExpanded(parse, fnnode, mayflags)) {
+            parseSkipBlock();
+            return (INode*)fnnode;
+        }
         fnnode->value = parseExprBlock(parse, 0);
     }
     else {
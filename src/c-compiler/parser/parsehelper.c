@@ -3,6 +3,7 @@
  *
  * - Statement end handling (; and inference)
  * - Block start and end (indented vs. free-flow)
+ * - Skipping a block unparsed
  * - Closing paren vs. bracket
  *
  * This source file is part of the Cone Programming Language C compiler
@@ -114,6 +115,50 @@ int parseBlockEnd() {
     return 0;
 }
 
+// Skip past a block without parsing it. Its end is found as parseExprBlock
+// would find it: a matching '}', or the indentation its statement started at.
+// A ':' starts a nested block unless it names an argument or follows a lifetime.
+void parseSkipBlock() {
+    parseBlockStart();
+    lexStmtStart();
+    while (!parseBlockEnd()) {
+        if (lexIsStmtBreak())
+            lexStmtStart();
+        switch (lex->toktype) {
+        case LCurlyToken:
+            parseSkipBlock();
+            break;
+        case ColonToken:
+            if (lex->blkStack[lex->blkStackLvl].paranscnt == 0)
+                parseSkipBlock();
+            else
+                lexNextToken();
+            break;
+        case LifetimeToken:
+            lexNextToken();
+            if (lexIsToken(ColonToken))
+                lexNextToken();
+            break;
+        case LParenToken:
+        case LBracketToken:
+            lexNextToken();
+            lexIncrParens();
+            break;
+        case RParenToken:
+        case RBracketToken:
+            lexNextToken();
+            lexDecrParens();
+            break;
+        case SemiToken:
+            lexNextToken();
+            lexStmtStart();
+            break;
+        default:
+            lexNextToken();
+        }
+    }
+}
+
 // Expect closing token (e.g., right parenthesis). If not found, search for it or '}' or ';'
 void parseCloseTok(uint16_t closetok) {
     if (!lexIsToken(closetok))
@@ -13,6 +13,7 @@
 #include "../shared/memory.h"
 #include "../shared/error.h"
 #include "../shared/fileio.h"
+#include "../shared/timer.h"
 #include "../ir/nametbl.h"
 #include "../coneopts.h"
 #include "lexer.h"
@@ -244,6 +245,9 @@ ModuleNode *parseLoadAndParseModuleFile(ParseState *parse, char *filename, Name
     char *svprefix = parse->gennamePrefix;
     nameNewPrefix(&parse->gennamePrefix, &modname->namestr);
 
+    if (timerTracing)
+        timerTraceBegin("ParseModule", *filename ? filename : &modname->namestr);
+
     // Create and add this new module to list of modules, and make it the current one
     ModuleNode *svmod = parse->mod;
     mod = pgmAddMod(parse->pgm, modname==corelibName || strcmp(filename, "stdio")? 0 : FlagGenMod);
@@ -279,11 +283,15 @@ ModuleNode *parseLoadAndParseModuleFile(ParseState *parse, char *filename, Name
     // Restore focus to original module we were working on
     parse->mod = svmod;
     parse->gennamePrefix = svprefix;
+    if (timerTracing)
+        timerTraceEnd();
     return mod;
 }
 
-// Parse a program = the main module
-ProgramNode *parsePgm(ConeOptions *opt) {
+// Start a program: set up the name table and lexer, and parse the core
+// library, which is the same for every source. The main module is added first,
+// as generation expects, and left empty until parsePgmMain fills it.
+ProgramNode *parsePgmStart(ConeOptions *opt) {
     // Initialize name table and lexer
     nametblInit();
     typetblInit();
@@ -299,17 +307,33 @@ ProgramNode *parsePgm(ConeOptions *opt) {
     parse.typenode = NULL;
     parse.gennamePrefix = "";
 
-    // Create module node and set up for parsing main source file
+    // Create the main module, then parse the core library ahead of it
     ModuleNode *mod = pgmAddMod(pgm, FlagGenMod);
     parse.pgmmod = mod;
-    lexInjectFile(opt->srcpath);
     modHook(NULL, mod);
+    parseLoadAndParseModuleFile(&parse, "", corelibName);
+    modHook(mod, NULL);
+    return pgm;
+}
+
+// Parse the main source file into the program parsePgmStart began
+void parsePgmMain(ProgramNode *pgm, ConeOptions *opt) {
+    // The main source's imports search its own paths, whatever options the
+    // core library was parsed under
+    fileSearchPaths = opt->package_search_paths;
 
-    // Inject and parse core library module, auto-imported into main source
-    ModuleNode *corelib = parseLoadAndParseModuleFile(&parse, "", corelibName);
+    ParseState parse;
+    parse.pgm = pgm;
+    parse.typenode = NULL;
+    parse.gennamePrefix = "";
+    ModuleNode *mod = (ModuleNode *)nodesGet(pgm->modules, 0);
+    parse.pgmmod = mod;
+    lexInjectFile(opt->srcpath);
+
+    // The core library is auto-imported into the main source
     ImportNode *importnode = newImportNode();
     importnode->foldall = 1;
-    importnode->module = corelib;
+    importnode->module = pgmFindMod(pgm, corelibName);
     modAddNode(mod, NULL, (INode*)importnode);
 
     // Now actually parse main source file
@@ -322,5 +346,11 @@ ProgramNode *parsePgm(ConeOptions *opt) {
     if (lex->toktype != EofToken)
         errorMsgLex(ErrorNoEof, "Expected end-of-file");
     modHook(mod, NULL);
+}
+
+// Parse a program = the main module
+ProgramNode *parsePgm(ConeOptions *opt) {
+    ProgramNode *pgm = parsePgmStart(opt);
+    parsePgmMain(pgm, opt);
     return pgm;
 }
@@ -29,10 +29,14 @@ enum ParseFlags {
 };
 
 // parsemod.c
+ProgramNode *parsePgmStart(ConeOptions *opt);
+void parsePgmMain(ProgramNode *pgm, ConeOptions *opt);
 ProgramNode *parsePgm(ConeOptions *opt);
 ModuleNode *parseModuleBlk(ParseState *parse, ModuleNode *mod);
 
 // parsefnflow.c
+// Whether a function's body is expanded wherever it is used, rather than called
+int parseFnIsExpanded(ParseState *parse, FnDclNode *fnnode, uint16_t mayflags);
 INode *parseFn(ParseState *parse, uint16_t mayflags);
 // Parse a macro declaration
 MacroDclNode *parseMacro(ParseState *parse);
@@ -80,6 +84,8 @@ int parseHasBlock();
 void parseBlockStart();
 // Are we at end of block yet? If so, consume token and reset lexer mode
 int parseBlockEnd();
+// Skip past a block without parsing it
+void parseSkipBlock();
 // Expect closing token (e.g., right parenthesis). If not found, search for it or '}' or ';'
 void parseCloseTok(uint16_t closetok);
 
@@ -0,0 +1,132 @@
+/** Scanning runs of bytes, sixteen at a time where the target allows
+ * @file
+ *
+ * The lexer spends most of its time stepping over runs of bytes that it does
+ * nothing with but find their end: indentation, comments, the body of a
+ * string, the rest of an identifier. Where SSE2 is part of the target -- every
+ * x86-64 compiler assumes it -- each of these scans compares sixteen bytes at a
+ * time and finds the first that ends the run from a bit mask. Elsewhere the
+ * same scans go a byte at a time.
+ *
+ * The vector loads are aligned, so none of them crosses into a page the
+ * string does not reach, however close to the end of its allocation the
+ * string's null lies. Bytes a load reads before p or past the null are never
+ * looked at.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "bytescan.h"
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BYTESCAN_SSE2
+#include <emmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+static int bytescanFirstBit(unsigned mask) {
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return (int)bit;
+}
+#else
+#define bytescanFirstBit(mask) __builtin_ctz(mask)
+#endif
+
+// Return the first byte from p for which STOPS, a 16-bit mask computed from
+// the sixteen bytes in v, has its bit set
+#define bytescanBlocks(p, STOPS) { \
+    const char *blk = (const char *)((uintptr_t)(p) & ~(uintptr_t)15); \
+    __m128i v = _mm_load_si128((const __m128i *)blk); \
+    unsigned mask = (unsigned)(STOPS) >> ((p) - blk); \
+    if (mask) \
+        return (p) + bytescanFirstBit(mask); \
+    while (1) { \
+        blk += 16; \
+        v = _mm_load_si128((const __m128i *)blk); \
+        mask = (unsigned)(STOPS); \
+        if (mask) \
+            return (char *)blk + bytescanFirstBit(mask); \
+    } \
+}
+
+// A mask of the bytes in v that equal c
+#define bytescanEq(v, c) _mm_movemask_epi8(_mm_cmpeq_epi8((v), _mm_set1_epi8(c)))
+
+// A mask of the bytes in v from lo up to lo+n-1. There is no unsigned byte
+// compare, so the range is moved to the bottom of the signed one.
+#define bytescanIn(v, lo, n) _mm_movemask_epi8(_mm_cmplt_epi8( \
+    _mm_add_epi8((v), _mm_set1_epi8((char)(0x80 - (lo)))), _mm_set1_epi8((char)(0x80 + (n)))))
+#endif
+
+// Return the first byte that is not c, which is not null
+char *bytescanPast(char *p, char c) {
+#ifdef BYTESCAN_SSE2
+    bytescanBlocks(p, bytescanEq(v, c) ^ 0xFFFF);
+#else
+    while (*p == c)
+        ++p;
+    return p;
+#endif
+}
+
+// Return the first byte that is neither a space nor a tab
+char *bytescanPastBlanks(char *p) {
+#ifdef BYTESCAN_SSE2
+    bytescanBlocks(p, (bytescanEq(v, ' ') | bytescanEq(v, '\t')) ^ 0xFFFF);
+#else
+    while (*p == ' ' || *p == '\t')
+        ++p;
+    return p;
+#endif
+}
+
+// Return the first byte that is not an ASCII letter, digit or underscore.
+// Setting 0x20 makes an upper case letter lower case, and no other byte a letter.
+char *bytescanPastIdent(char *p) {
+#ifdef BYTESCAN_SSE2
+    bytescanBlocks(p, (bytescanIn(v, '0', 10) | bytescanEq(v, '_')
+        | bytescanIn(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 26)) ^ 0xFFFF);
+#else
+    while ((*p >= '0' && *p <= '9') || *p == '_' || ((*p | 0x20) >= 'a' && (*p | 0x20) <= 'z'))
+        ++p;
+    return p;
+#endif
+}
+
+// Return the first byte that is not ASCII
+char *bytescanPastAscii(char *p) {
+#ifdef BYTESCAN_SSE2
+    bytescanBlocks(p, _mm_movemask_epi8(v) | bytescanEq(v, 0));
+#else
+    while (*p && !(*p & 0x80))
+        ++p;
+    return p;
+#endif
+}
+
+// Return the first byte that is a, b or c
+char *bytescanFind(char *p, char a, char b, char c) {
+#ifdef BYTESCAN_SSE2
+    bytescanBlocks(p, bytescanEq(v, a) | bytescanEq(v, b) | bytescanEq(v, c) | bytescanEq(v, 0));
+#else
+    while (*p && *p != a && *p != b && *p != c)
+        ++p;
+    return p;
+#endif
+}
+
+// Return the first byte that is a quote, a backslash or a control character
+char *bytescanFindStringEnd(char *p) {
+#ifdef BYTESCAN_SSE2
+    bytescanBlocks(p, bytescanEq(v, '"') | bytescanEq(v, '\\')
+        | _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1F)), v)));
+#else
+    while (*p != '"' && *p != '\\' && (unsigned char)*p >= ' ')
+        ++p;
+    return p;
+#endif
+}
@@ -0,0 +1,32 @@
+/** Scanning runs of bytes, sixteen at a time where the target allows
+ * @file
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#ifndef bytescan_h
+#define bytescan_h
+
+// Each scans a null-terminated string from p, returning a pointer to the
+// first byte that ends the run it names. A null byte always ends one.
+
+// Return the first byte that is not c, which is not null
+char *bytescanPast(char *p, char c);
+
+// Return the first byte that is neither a space nor a tab
+char *bytescanPastBlanks(char *p);
+
+// Return the first byte that is not an ASCII letter, digit or underscore
+char *bytescanPastIdent(char *p);
+
+// Return the first byte that is not ASCII
+char *bytescanPastAscii(char *p);
+
+// Return the first byte that is a, b or c
+char *bytescanFind(char *p, char a, char b, char c);
+
+// Return the first byte that is a quote, a backslash or a control character
+char *bytescanFindStringEnd(char *p);
+
+#endif
@@ -91,24 +91,28 @@ void errorOutCode(char *tokp, uint32_t linenbr, char *linep, char *url, int code
 // One frame of an instantiation trace, without following the chain further
 static void errorMsgFrame(INode *node, int code, const char *msg, ...) {
     va_list argptr;
+    SrcPos pos;
+    srclocDecode(node->srcloc, &pos);
     va_start(argptr, msg);
-    errorOutCode(node->srcp, node->linenbr, node->linep, node->lexer->url, code, msg, argptr);
+    errorOutCode(pos.tokp, pos.linenbr, pos.linep, pos.url, code, msg, argptr);
     va_end(argptr);
 }
 
 // Send an error message to stderr
 void errorMsgNode(INode *node, int code, const char *msg, ...) {
     va_list argptr;
+    SrcPos pos;
+    srclocDecode(node->srcloc, &pos);
     va_start(argptr, msg);
-    errorOutCode(node->srcp, node->linenbr, node->linep, node->lexer->url, code, msg, argptr);
+    errorOutCode(pos.tokp, pos.linenbr, pos.linep, pos.url, code, msg, argptr);
     va_end(argptr);
 
     // Name what instantiated this node, and what instantiated that, outward
     uint32_t shown = 0;
-    for (INode *instnode = node->instnode; instnode; instnode = instnode->instnode) {
+    for (INode *instnode = inodeGetInstnode(node); instnode; instnode = inodeGetInstnode(instnode)) {
         if (shown++ == ErrorInstTraceMax) {
             uint32_t more = 0;
-            for (INode *rest = instnode; rest; rest = rest->instnode)
+            for (INode *rest = instnode; rest; rest = inodeGetInstnode(rest))
                 ++more;
             errorMsg(Uncounted, "... and %u further instantiation%s not shown", more, more == 1 ? "" : "s");
             break;
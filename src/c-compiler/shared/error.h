@@ -141,18 +141,23 @@ enum ErrorCode {
     // means a compiler defect, not a bad program. See errorUnreachable.
     ErrorUnreachable = 1075,    // A state the compiler had established cannot happen
 
+    // Function multiversioning
+    ErrorBadClones = 1076,      // Malformed or misplaced '@target_clones' attribute
+
     // Warnings
     WarnCode = 3000,
     WarnName = 3001,        // Unnecessary name
     WarnIndent = 3002,        // Inconsistent indent character
     WarnCopy = 3003,       // Unsafe attempt to copy a CopyMethod or CopyMove typed value
     WarnLoop = 3004,       // Infinite loop with no break
+    WarnEncoding = 3005,   // Source is not well-formed UTF-8
 
     // Uncounted
     Uncounted = 9000,
 };
 
 extern int errors;
+extern int warnings;
 
 // Send an error message to stderr
 void errorExit(int exitcode, const char *msg, ...);
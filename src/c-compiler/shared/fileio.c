@@ -9,10 +9,23 @@
 #include "memory.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stddef.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <limits.h>
+#include <mach-o/dyld.h>
+#else
+#include <limits.h>
+#include <unistd.h>
+#endif
 
 char **fileSearchPaths = NULL;
+void (*fileLoadHook)(char *fn, char *src) = NULL;
 
 /** Load a file into an allocated string, return pointer or NULL if not found */
 char *fileLoad(char *fn) {
@@ -136,10 +149,90 @@ char *fileSrcUrl(char *cururl, char *srcfn, int newfolder) {
 char *fileLoadSrcWithFolder(char *cururl, char *srcfn, char **fn) {
     char *src;
     *fn = fileSrcUrl(cururl, srcfn, 0);
-    if (src = fileLoad(*fn))
+    src = fileLoad(*fn);
+    if (fileLoadHook)
+        fileLoadHook(*fn, src);
+    if (src)
         return src;
     *fn = fileSrcUrl(cururl, srcfn, 1);
-    return fileLoad(*fn);
+    src = fileLoad(*fn);
+    if (fileLoadHook)
+        fileLoadHook(*fn, src);
+    return src;
+}
+
+// Get a file's size and when it was last modified. Returns 0 if there is no file.
+int fileStat(char *fn, uint64_t *size, int64_t *mtime) {
+    struct stat st;
+    if (stat(fn, &st) != 0)
+        return 0;
+    *size = (uint64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return 1;
+}
+
+// The absolute path of a file that exists, with no '.', '..' or link in it,
+// or fn itself if it cannot be resolved
+char *fileFullPath(char *fn) {
+#ifdef _WIN32
+    char full[_MAX_PATH];
+    if (_fullpath(full, fn, sizeof(full)) == NULL)
+        return fn;
+#else
+    char *full = realpath(fn, NULL);
+    if (full == NULL)
+        return fn;
+#endif
+    char *path = memAllocStr(full, strlen(full));
+#ifndef _WIN32
+    free(full);
+#endif
+    return path;
+}
+
+// The path of the running executable, which was started as argv0, or NULL if
+// it cannot be found
+char *fileExePath(char *argv0) {
+#ifdef _WIN32
+    char path[MAX_PATH];
+    DWORD len = GetModuleFileNameA(NULL, path, sizeof(path));
+    if (len > 0 && len < sizeof(path))
+        return memAllocStr(path, len);
+#elif defined(__APPLE__)
+    char path[PATH_MAX];
+    uint32_t size = sizeof(path);
+    if (_NSGetExecutablePath(path, &size) == 0)
+        return fileFullPath(path);
+#else
+    char path[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (len > 0)
+        return memAllocStr(path, len);
+#endif
+
+    // Otherwise argv0 is a path to it, or a name found on PATH
+    struct stat st;
+    if (argv0 == NULL || *argv0 == '\0')
+        return NULL;
+    if (strchr(argv0, '/') || strchr(argv0, '\\'))
+        return stat(argv0, &st) == 0 ? fileFullPath(argv0) : NULL;
+#ifdef _WIN32
+    char sep = ';';
+#else
+    char sep = ':';
+#endif
+    char *dirs = getenv("PATH");
+    while (dirs && *dirs) {
+        char *end = strchr(dirs, sep);
+        size_t dirlen = end ? (size_t)(end - dirs) : strlen(dirs);
+        char *exe = memAllocStr(dirs, dirlen + strlen(argv0) + 1);
+        exe[dirlen] = '/';
+        strcpy(exe + dirlen + 1, argv0);
+        if (dirlen && stat(exe, &st) == 0)
+            return fileFullPath(exe);
+        dirs = end ? end + 1 : NULL;
+    }
+    return NULL;
 }
 
 // Search for and load source file, where srcfn is relative to cururl
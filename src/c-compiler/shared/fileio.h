@@ -8,14 +8,24 @@
 #ifndef fileio_h
 #define fileio_h
 
+#include <stddef.h>
+#include <stdint.h>
+
 extern char **fileSearchPaths;
 
+// If set, called with each path fileLoadSrc looks for a source file at, and
+// what it loaded from there, or NULL if nothing was there
+extern void (*fileLoadHook)(char *fn, char *src);
+
 // Load a file into an allocated string, return pointer or NULL if not found
 char *fileLoad(char *fn);
 
 // Extract a filename only (no extension) from a path
 char *fileName(char *fn);
 
+// Get number of characters in a path up to its file name
+size_t fileFolder(char *fn);
+
 // Concatenate folder, filename and extension into a path
 char *fileMakePath(char *dir, char *srcfn, char *ext);
 
@@ -27,4 +37,15 @@ char *fileSrcUrl(char *cururl, char *srcfn, int newfolder);
 // - return full pathname for source file
 char *fileLoadSrc(char *cururl, char *srcfn, char **fn);
 
+// Get a file's size and when it was last modified. Returns 0 if there is no file.
+int fileStat(char *fn, uint64_t *size, int64_t *mtime);
+
+// The absolute path of a file that exists, with no '.', '..' or link in it,
+// or fn itself if it cannot be resolved
+char *fileFullPath(char *fn);
+
+// The path of the running executable, which was started as argv0, or NULL if
+// it cannot be found
+char *fileExePath(char *argv0);
+
 #endif
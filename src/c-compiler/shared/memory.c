@@ -5,6 +5,17 @@
  * Allocation is done via bump pointer within very large arenas allocated from the heap
  * Nothing is ever freed.
  *
+ * Every allocation is counted under what it is for (see MemCat), and IR nodes
+ * also by their tag, for --stats. As nothing is freed, what is no longer used is
+ * counted as orphaned rather than freed: the tables a hash table grew out of,
+ * and what was left of an arena when an allocation did not fit in it.
+ *
+ * Arenas are malloc'd a gMemBlkArenaSize or gMemStrArenaSize at a time, unless
+ * memArenaReserve has them all come from one large range of address space
+ * reserved up front. The OS commits its pages only as they are first touched,
+ * so what is reserved and never used costs nothing, and nothing is left behind
+ * at the end of an arena until the whole range is used up.
+ *
  * This source file is part of the Cone Programming Language C compiler
  * See Copyright Notice in conec.h
 */
@@ -17,9 +28,14 @@
 #include <string.h>
 #include <stddef.h>
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
 // Public globals: Arena size configuration values
 size_t gMemBlkArenaSize = 256 * 4096;
 size_t gMemStrArenaSize = 128 * 4096;
+size_t gMemReserveSize = sizeof(void*) >= 8 ? (size_t)64 << 30 : (size_t)1 << 30;
 
 // Private globals: memory allocation arena bookkeeping
 static void *gMemBlkArenaPos = NULL;
@@ -29,12 +45,49 @@ static size_t gMemStrArenaLeft = 0;
 
 static size_t memAllocated = 0;
 
-/** Allocate memory for a block, aligned to a 16-byte boundary */
-void *memAllocBlk(size_t size) {
+// What is known of the memory allocated for one category or node tag
+typedef struct {
+    size_t count;       // Allocations
+    size_t bytes;       // Bytes allocated, after alignment
+    size_t orphaned;    // Bytes no longer used
+    size_t peak;        // Most bytes in use (allocated, less orphaned) at once
+} MemStats;
+
+static MemStats memCatStats[MemCatCount];
+
+// Node tags are indexed by their top four flag bits and their low six bits,
+// which is all of any tag in inode.h
+#define memTagIndex(tag) ((((tag) >> 12) << 6) | ((tag) & 0x3f))
+#define memTagCount (16 << 6)
+static MemStats memTagStats[memTagCount];
+
+// Arena space never used, because an allocation did not fit in what was left
+static size_t memBlkTails = 0;
+static size_t memBlkArenas = 0;
+static size_t memStrTails = 0;
+static size_t memStrArenas = 0;
+
+// The address range memArenaReserve reserved, if it did
+static char *memReserved = NULL;
+static char *memReservedStr = NULL;     // Where strings begin in it
+static size_t memReservedSize = 0;
+static int memReservedHuge = 0;
+
+static void memCount(MemStats *stats, size_t size) {
+    ++stats->count;
+    stats->bytes += size;
+    size_t inuse = stats->bytes - stats->orphaned;
+    if (inuse > stats->peak)
+        stats->peak = inuse;
+}
+
+/** Allocate memory for a block, aligned to a 16-byte boundary, counted under cat */
+void *memAllocFor(int cat, size_t size) {
     void *memp;
 
     // Align to 16-byte boundary
     size = (size + 15) & ~15;
+    memCount(&memCatStats[cat], size);
 
     // Return next bite out of arena, if it fits
     if (size <= gMemBlkArenaLeft) {
@@ -54,6 +107,8 @@ void *memAllocBlk(size_t size) {
     }
 
     // Allocate a new Arena and return next bite out of it
+    memBlkTails += gMemBlkArenaLeft;
+    ++memBlkArenas;
     gMemBlkArenaPos = malloc(gMemBlkArenaSize);
     memAllocated += gMemBlkArenaSize;
     if (gMemBlkArenaPos==NULL)
@@ -71,6 +126,7 @@ char *memAllocStr(char *str, size_t size) {
 
     // Give it room for C-string null terminator
     size += 1;
+    memCount(&memCatStats[MemStrCat], size);
 
     // Return next bite out of arena, if it fits
     if (size <= gMemStrArenaLeft) {
@@ -89,6 +145,8 @@ char *memAllocStr(char *str, size_t size) {
 
     // Allocate a new Arena and return next bite out of it
     else {
+        memStrTails += gMemStrArenaLeft;
+        ++memStrArenas;
         gMemStrArenaPos = malloc(gMemStrArenaSize);
         memAllocated += gMemStrArenaSize;
         if (gMemStrArenaPos==NULL)
@@ -106,8 +164,110 @@ char *memAllocStr(char *str, size_t size) {
     return (char*) strp;
 }
 
+/** Allocate memory for an IR node, counted by its tag */
+void *memAllocNode(uint16_t tag, size_t size) {
+    memCount(&memTagStats[memTagIndex(tag)], (size + 15) & ~15);
+    return memAllocFor(MemNodeCat, size);
+}
+
+/** Count a block under cat that is no longer used, but is never freed */
+void memOrphan(int cat, size_t size) {
+    memCatStats[cat].orphaned += (size + 15) & ~15;
+}
+
+/** Have arenas bump-allocate out of one large range of address space from now on,
+ * reserved up front and committed by the OS as it is touched, instead of a fresh
+ * malloc for each. With huge, ask that the range be backed by transparent huge
+ * pages. Returns 0 if the OS would not reserve it, and malloc'd arenas carry on. */
+int memArenaReserve(int huge) {
+#if defined(_WIN32) || !defined(MAP_NORESERVE)
+    // Windows commits reserved pages only when asked to, not as they are touched
+    return 0;
+#else
+    if (memReserved)
+        return 1;
+
+    // Huge pages must be aligned to their size, so reserve enough to align to it
+    size_t align = (size_t)2 << 20;
+    size_t size = gMemReserveSize;
+    char *base = (char *)mmap(NULL, size + align, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == (char *)MAP_FAILED)
+        return 0;
+    char *start = (char *)(((size_t)base + align - 1) & ~(align - 1));
+#ifdef MADV_HUGEPAGE
+    if (huge && madvise(start, size, MADV_HUGEPAGE) == 0)
+        memReservedHuge = 1;
+#endif
+    memReserved = start;
+    memReservedSize = size;
+    memAllocated += size;
+
+    // Blocks bump up from the start, strings from three quarters of the way in.
+    // What is left of the arenas malloc'd so far is abandoned.
+    memBlkTails += gMemBlkArenaLeft;
+    memStrTails += gMemStrArenaLeft;
+    gMemBlkArenaPos = start;
+    gMemBlkArenaLeft = size / 4 * 3;
+    gMemStrArenaPos = memReservedStr = start + gMemBlkArenaLeft;
+    gMemStrArenaLeft = size - gMemBlkArenaLeft;
+    return 1;
+#endif
+}
+
 size_t nametblUnused();
 // Return how much memory actually needed for use
 size_t memUsed() {
     return memAllocated - gMemBlkArenaLeft - gMemStrArenaLeft - nametblUnused();
 }
+
+static char *memCatNames[MemCatCount] = {
+    "nodes", "node lists", "name table", "type table", "namespaces", "strings", "LLVM buffers", "other"
+};
+
+/** Print memory use by category and by node tag, naming tags with tagname */
+void memPrintStats(char *(*tagname)(uint16_t tag)) {
+    MemStats total = { 0, 0, 0, 0 };
+    printf("Memory by category        count        bytes     orphaned         peak\n");
+    for (int cat = 0; cat < MemCatCount; ++cat) {
+        MemStats *stats = &memCatStats[cat];
+        printf("  %-16s %12zu %12zu %12zu %12zu\n", memCatNames[cat],
+            stats->count, stats->bytes, stats->orphaned, stats->peak);
+        total.count += stats->count;
+        total.bytes += stats->bytes;
+        total.orphaned += stats->orphaned;
+    }
+    printf("  %-16s %12zu %12zu %12zu\n", "total", total.count, total.bytes, total.orphaned);
+    printf("Arena tails abandoned: %zu bytes over %zu block arenas, %zu bytes over %zu string arenas\n",
+        memBlkTails, memBlkArenas, memStrTails, memStrArenas);
+    if (memReserved) {
+        // Either part may have run out, and moved on to malloc'd arenas
+        char *blkpos = (char *)gMemBlkArenaPos;
+        char *strpos = (char *)gMemStrArenaPos;
+        char *end = memReserved + memReservedSize;
+        size_t used = (blkpos >= memReserved && blkpos <= memReservedStr ? blkpos : memReservedStr) - memReserved;
+        used += (strpos >= memReservedStr && strpos <= end ? strpos : end) - memReservedStr;
+        printf("Reserved arena: %zu of %zu bytes used%s\n", used, memReservedSize,
+            memReservedHuge ? ", on huge pages" : "");
+    }
+
+    // Node tags, most bytes first
+    int order[memTagCount];
+    int ntags = 0;
+    for (int i = 0; i < memTagCount; ++i) {
+        if (memTagStats[i].count == 0)
+            continue;
+        int pos = ntags++;
+        while (pos > 0 && memTagStats[order[pos - 1]].bytes < memTagStats[i].bytes) {
+            order[pos] = order[pos - 1];
+            --pos;
+        }
+        order[pos] = i;
+    }
+    printf("Memory by node tag        count        bytes\n");
+    for (int i = 0; i < ntags; ++i) {
+        MemStats *stats = &memTagStats[order[i]];
+        uint16_t tag = (uint16_t)(((order[i] >> 6) << 12) | (order[i] & 0x3f));
+        printf("  %-16s %12zu %12zu\n", tagname(tag), stats->count, stats->bytes);
+    }
+}
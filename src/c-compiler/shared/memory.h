@@ -10,19 +10,51 @@
 
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
 
 // Configurable size for arenas (specify as multiples of 4096 byte pages)
 extern size_t gMemBlkArenaSize;    // Default is 256 pages
 extern size_t gMemStrArenaSize;    // Default is 128 pages
+extern size_t gMemReserveSize;     // Address space memArenaReserve reserves (default 64 GiB)
+
+// What memory is allocated for, so that --stats can say where it went
+enum MemCat {
+    MemNodeCat,         // IR nodes, which memAllocNode also counts by tag
+    MemNodesCat,        // Lists of nodes, as they are created and grow
+    MemNameTblCat,      // The name table, its names and its hook tables
+    MemTypeTblCat,      // The type table
+    MemNamespaceCat,    // Namespaces of modules and types
+    MemStrCat,          // Strings: sources, paths, generated names, literals
+    MemGenCat,          // Buffers generation builds for LLVM
+    MemOtherCat,        // Everything else
+    MemCatCount
+};
 
 // Allocate memory for a block, aligned to a 16-byte boundary
-void *memAllocBlk(size_t size);
+#define memAllocBlk(size) memAllocFor(MemOtherCat, size)
+
+// Allocate memory for a block, aligned to a 16-byte boundary, counted under cat
+void *memAllocFor(int cat, size_t size);
+
+// Allocate memory for an IR node, counted by its tag
+void *memAllocNode(uint16_t tag, size_t size);
 
 // Allocate memory for a string and copy contents over, if not NULL
 // Allocates extra byte for string-ending 0, appending it to copied string
 char *memAllocStr(char *str, size_t size);
 
+// Count a block under cat that is no longer used, but is never freed:
+// typically the old table a hash table grew out of
+void memOrphan(int cat, size_t size);
+
+// Have arenas bump-allocate out of one large reserved address range from now on,
+// optionally on huge pages. Returns 0 if the OS would not reserve it.
+int memArenaReserve(int huge);
+
 // Return memory allocated and used
 size_t memUsed();
 
+// Print memory use by category and by node tag, naming tags with tagname
+void memPrintStats(char *(*tagname)(uint16_t tag));
+
 #endif
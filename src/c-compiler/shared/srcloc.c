@@ -0,0 +1,129 @@
+/** Source locations
+ * @file
+ *
+ * A node records where it came from as one 32-bit SrcLoc rather than as a
+ * lexer, token, line start and line number. A location is only ever needed
+ * to report an error or emit debug info, so it is decoded then: the source
+ * is found by a binary search of the sources read, and its line by a binary
+ * search of that source's line starts, which are counted the first time
+ * anything in it is decoded.
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include "srcloc.h"
+#include "memory.h"
+#include "error.h"
+
+#include <string.h>
+
+// A source that has been read, and where its locations begin
+typedef struct {
+    char *url;
+    char *source;
+    SrcLoc base;        // Location of the source's first byte
+    uint32_t size;      // Its length, not counting the terminator
+    uint32_t *lines;    // Offset of each line's start, once something in it is decoded
+    uint32_t nlines;
+} SrcFile;
+
+static SrcFile *srcFiles = NULL;
+static uint32_t srcFileCnt = 0;
+static uint32_t srcFileAvail = 0;
+
+// Location 0 is nowhere, so the first source starts at 1
+static SrcLoc srcNextBase = 1;
+
+// Add a source about to be read, returning the location of its first byte
+SrcLoc srclocAdd(char *url, char *source) {
+    if (srcFileCnt == srcFileAvail) {
+        uint32_t oldavail = srcFileAvail;
+        srcFileAvail = srcFileAvail ? srcFileAvail << 1 : 32;
+        SrcFile *files = (SrcFile *)memAllocBlk(srcFileAvail * sizeof(SrcFile));
+        if (srcFileCnt)
+            memcpy(files, srcFiles, srcFileCnt * sizeof(SrcFile));
+        memOrphan(MemOtherCat, oldavail * sizeof(SrcFile));
+        srcFiles = files;
+    }
+
+    // The terminator gets a location too, for the end-of-file token
+    size_t size = strlen(source);
+    if (size >= (SrcLoc)-1 - srcNextBase)
+        errorExit(ExitMem, "Sources read total more than 4GB");
+    SrcFile *file = &srcFiles[srcFileCnt++];
+    file->url = url;
+    file->source = source;
+    file->base = srcNextBase;
+    file->size = (uint32_t)size;
+    file->lines = NULL;
+    file->nlines = 0;
+    srcNextBase += (SrcLoc)size + 1;
+    return file->base;
+}
+
+// Find the source a location is in, or NULL if it is nowhere
+static SrcFile *srclocFile(SrcLoc loc) {
+    if (loc == 0 || srcFileCnt == 0)
+        return NULL;
+    uint32_t lo = 0;
+    uint32_t hi = srcFileCnt;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) >> 1;
+        if (srcFiles[mid].base <= loc)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return &srcFiles[lo];
+}
+
+// Count where a source's lines start
+static void srclocLines(SrcFile *file) {
+    uint32_t nlines = 1;
+    for (char *srcp = file->source; *srcp; ++srcp) {
+        if (*srcp == '\n')
+            ++nlines;
+    }
+    file->lines = (uint32_t *)memAllocBlk(nlines * sizeof(uint32_t));
+    file->lines[0] = 0;
+    file->nlines = 1;
+    for (char *srcp = file->source; *srcp; ++srcp) {
+        if (*srcp == '\n')
+            file->lines[file->nlines++] = (uint32_t)(srcp + 1 - file->source);
+    }
+}
+
+// Decode a location into its source, line and position on that line
+void srclocDecode(SrcLoc loc, SrcPos *pos) {
+    SrcFile *file = srclocFile(loc);
+    if (file == NULL) {
+        pos->url = "";
+        pos->linep = pos->tokp = "";
+        pos->linenbr = 0;
+        return;
+    }
+    if (file->lines == NULL)
+        srclocLines(file);
+
+    uint32_t offset = loc - file->base;
+    uint32_t lo = 0;
+    uint32_t hi = file->nlines;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) >> 1;
+        if (file->lines[mid] <= offset)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    pos->url = file->url;
+    pos->linep = file->source + file->lines[lo];
+    pos->tokp = file->source + offset;
+    pos->linenbr = lo + 1;
+}
+
+// The url of the source a location is in
+char *srclocUrl(SrcLoc loc) {
+    SrcFile *file = srclocFile(loc);
+    return file ? file->url : "";
+}
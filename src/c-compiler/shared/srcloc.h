@@ -0,0 +1,35 @@
+/** Source locations
+ * @file
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#ifndef srcloc_h
+#define srcloc_h
+
+#include <stdint.h>
+
+// Where in the source something came from, as an offset into every source the
+// compile has read, laid end to end in the order they were read.
+// 0 is nowhere in particular.
+typedef uint32_t SrcLoc;
+
+// What a source location decodes to, for an error message
+typedef struct {
+    char *url;          // The url where the source text came from
+    char *linep;        // Start of the line the location is on
+    char *tokp;         // The location itself
+    uint32_t linenbr;   // Line number, starting with 1
+} SrcPos;
+
+// Add a source about to be read, returning the location of its first byte
+SrcLoc srclocAdd(char *url, char *source);
+
+// Decode a location into its source, line and position on that line
+void srclocDecode(SrcLoc loc, SrcPos *pos);
+
+// The url of the source a location is in
+char *srclocUrl(SrcLoc loc);
+
+#endif
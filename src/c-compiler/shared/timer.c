@@ -1,6 +1,12 @@
 /** Timer Handling
  * @file
  *
+ * Two kinds of timing. Each stage's total, for -V, is kept by switching
+ * between flat accumulators, which is cheap enough to do on every token.
+ * A time trace, for --time-trace, is nested: a scope for each stage, module,
+ * declaration and instantiation, written as Chrome trace events so that
+ * chrome://tracing or Perfetto draws it as a flame chart.
+ *
  * This source file is part of the Cone Programming Language C compiler
  * See Copyright Notice in conec.h
 */
@@ -8,6 +14,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include "timer.h"
+#include "error.h"
 
 size_t timerCurrent = TimerCount;
 uint64_t timerStamp = 0;
@@ -27,10 +34,12 @@ uint64_t timerTick() {
 }
 #else
 #include <time.h>
+// The monotonic clock, so that no adjustment of the time of day can make an
+// interval negative, in nanoseconds since whenever the system counts from
 uint64_t timerGet() {
     struct timespec tp;
-    clock_gettime(CLOCK_REALTIME, &tp);
-    return (uint64_t)tp.tv_nsec;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t)tp.tv_sec * 1000000000u + (uint64_t)tp.tv_nsec;
 }
 uint64_t timerTick() {
     return 1000000000;
@@ -45,6 +54,12 @@ void timerBegin(size_t aTimer) {
     timerCurrent = aTimer;
 }
 
+void timerReset() {
+    for (int i = 0; i < TimerCount; ++i)
+        timers[i] = 0;
+    timerCurrent = TimerCount;
+}
+
 uint64_t timerGetTicks(size_t aTimer) {
     return timers[aTimer];
 }
@@ -73,3 +88,100 @@ void timerPrint() {
     printf("  Codegen:    %.6g\n", timerGetSecs(CodeGenTimer));
     puts("");
 }
+
+// *** Time trace ***
+
+// Deeper scopes than this are timed as part of the one they are in
+#define TimerTraceDepth 512
+
+// A scope not yet ended
+typedef struct {
+    char *name;
+    char *detail;
+    uint64_t start;
+} TimerTraceScope;
+
+int timerTracing = 0;
+static FILE *timerTraceFile;
+static uint64_t timerTraceStart;
+static TimerTraceScope timerTraceStack[TimerTraceDepth];
+static int timerTraceDepth;
+static int timerTraceEvents;    // How many have been written
+
+// Start writing a time trace to the file at path
+void timerTraceOpen(char *path) {
+    timerTraceFile = fopen(path, "w");
+    if (timerTraceFile == NULL) {
+        errorMsg(ErrorGenErr, "Could not write time trace file %s", path);
+        return;
+    }
+    // The array form, whose closing bracket a viewer does without, so a
+    // compile that exits early still leaves a trace of what it did
+    fputs("[", timerTraceFile);
+    timerTraceStart = timerGet();
+    timerTraceDepth = 0;
+    timerTraceEvents = 0;
+    timerTracing = 1;
+}
+
+// Write a string as a JSON string
+static void timerTraceStr(char *str) {
+    fputc('"', timerTraceFile);
+    for (unsigned char *p = (unsigned char *)str; *p; ++p) {
+        if (*p == '"' || *p == '\\')
+            fprintf(timerTraceFile, "\\%c", *p);
+        else if (*p < ' ')
+            fprintf(timerTraceFile, "\\u%04x", *p);
+        else
+            fputc(*p, timerTraceFile);
+    }
+    fputc('"', timerTraceFile);
+}
+
+// Write one complete event: what was timed, from start to end (timerGet's
+// ticks), on thread tid. detail, which may be NULL, says what it was done to.
+void timerTraceEvent(char *name, char *detail, uint64_t start, uint64_t end, int tid) {
+    if (!timerTracing)
+        return;
+    double ticksPerUs = timerTick() / 1e6;
+    fprintf(timerTraceFile, "%s\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+        timerTraceEvents++ ? "," : "", tid,
+        (start - timerTraceStart) / ticksPerUs, (end - start) / ticksPerUs);
+    timerTraceStr(name);
+    if (detail) {
+        fputs(",\"args\":{\"detail\":", timerTraceFile);
+        timerTraceStr(detail);
+        fputc('}', timerTraceFile);
+    }
+    fputc('}', timerTraceFile);
+}
+
+// Begin a scope, on the compiler's own thread. Call only while timerTracing.
+void timerTraceBegin(char *name, char *detail) {
+    if (timerTraceDepth < TimerTraceDepth) {
+        TimerTraceScope *scope = &timerTraceStack[timerTraceDepth];
+        scope->name = name;
+        scope->detail = detail;
+        scope->start = timerGet();
+    }
+    ++timerTraceDepth;
+}
+
+// End the scope most recently begun
+void timerTraceEnd() {
+    if (--timerTraceDepth < TimerTraceDepth) {
+        TimerTraceScope *scope = &timerTraceStack[timerTraceDepth];
+        timerTraceEvent(scope->name, scope->detail, scope->start, timerGet(), 0);
+    }
+}
+
+// Finish the time trace, ending any scope still open
+void timerTraceClose() {
+    if (!timerTracing)
+        return;
+    while (timerTraceDepth > 0)
+        timerTraceEnd();
+    fputs("\n]\n", timerTraceFile);
+    fclose(timerTraceFile);
+    timerTracing = 0;
+}
@@ -27,6 +27,9 @@ enum Timers {
 // Start timing ticks for a specific timer
 void timerBegin(size_t aTimer);
 
+// Zero every timer, for a compile in a process that another's setup left timed
+void timerReset();
+
 // Get the tick count for a timer
 uint64_t timerGetTicks(size_t aTimer);
 
@@ -39,4 +42,29 @@ double timerSummary();
 // Print out all timers
 void timerPrint();
 
+// Get the current time, in ticks
+uint64_t timerGet();
+
+// How many ticks timerGet counts a second
+uint64_t timerTick();
+
+// Whether a time trace is being written. Check it before beginning a scope.
+extern int timerTracing;
+
+// Start writing a time trace to the file at path
+void timerTraceOpen(char *path);
+
+// Begin a scope, on the compiler's own thread. Call only while timerTracing.
+void timerTraceBegin(char *name, char *detail);
+
+// End the scope most recently begun
+void timerTraceEnd();
+
+// Write one complete event: what was timed, from start to end (timerGet's
+// ticks), on thread tid. detail, which may be NULL, says what it was done to.
+void timerTraceEvent(char *name, char *detail, uint64_t start, uint64_t end, int tid);
+
+// Finish the time trace, ending any scope still open
+void timerTraceClose();
+
 #endif
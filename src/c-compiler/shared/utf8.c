@@ -6,7 +6,9 @@
 */
 
 #include "utf8.h"
+#include "bytescan.h"
 #include <ctype.h>
+#include <stddef.h>
 
 /** Return the current unicode character whose UTF-8 bytes start at lex->bytepos */
 uint32_t utf8GetCode(const char *src) {
@@ -33,3 +35,33 @@ uint32_t utf8GetCode(const char *src) {
 int utf8IsLetter(const char* srcp) {
     return utf8IsMultibyte(srcp) || isalpha(*srcp);
 }
+
+// Return the first byte of a null-terminated string that does not begin a
+// well-formed UTF-8 character, or NULL if there is none. Overlong forms,
+// surrogates and code points past U+10FFFF are not well formed.
+// Runs of ASCII, which is most of any source, are stepped over in bulk.
+char *utf8Invalid(char *src) {
+    while (1) {
+        src = bytescanPastAscii(src);
+        unsigned char first = *src;
+        int nbytes;
+        uint32_t chr, least;
+        if (first == '\0')
+            return NULL;
+        else if ((first & 0xE0) == 0xC0) {nbytes = 2; chr = first & 0x1F; least = 0x80;}
+        else if ((first & 0xF0) == 0xE0) {nbytes = 3; chr = first & 0x0F; least = 0x800;}
+        else if ((first & 0xF8) == 0xF0) {nbytes = 4; chr = first & 0x07; least = 0x10000;}
+        else
+            return src;
+
+        // A null is not a continuation byte, so this stops at the string's end
+        for (int i = 1; i < nbytes; ++i) {
+            if ((src[i] & 0xC0) != 0x80)
+                return src;
+            chr = (chr << 6) + (src[i] & 0x3F);
+        }
+        if (chr < least || chr > 0x10FFFF || (chr >= 0xD800 && chr <= 0xDFFF))
+            return src;
+        src += nbytes;
+    }
+}
@@ -23,5 +23,6 @@
 
 uint32_t utf8GetCode(const char *src);
 int utf8IsLetter(const char* srcp);
+char *utf8Invalid(char *src);
 
 #endif
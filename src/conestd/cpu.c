@@ -0,0 +1,77 @@
+/** cpu - Run-time CPU feature detection
+ * @file
+ *
+ * This source file is part of the Cone Programming Language C compiler
+ * See Copyright Notice in conec.h
+*/
+
+#include <stdint.h>
+
+// Bits of coneCpuFeatures' answer. The order is that of fnCloneFeatures in the
+// compiler (ir/stmt/fndcl.c), which tests them in the resolver of every
+// '@target_clones' function, so the two lists must change together.
+enum {
+    CpuSse42, CpuPopcnt, CpuAvx, CpuBmi, CpuBmi2, CpuFma, CpuAvx2,
+    CpuAvx512f, CpuAvx512cd, CpuAvx512dq, CpuAvx512bw, CpuAvx512vl
+};
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+    __cpuidex((int *)regs, (int)leaf, (int)subleaf);
+}
+static uint64_t xgetbv() {
+    return _xgetbv(0);
+}
+#define CPU_X86
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+}
+static uint64_t xgetbv() {
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+}
+#define CPU_X86
+#endif
+
+// Return which of the features a '@target_clones' version may require this CPU has.
+// A vector extension counts only if the operating system also saves its registers.
+uint64_t coneCpuFeatures() {
+    uint64_t features = 0;
+#ifdef CPU_X86
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    unsigned maxleaf = regs[0];
+    if (maxleaf < 1)
+        return 0;
+
+    cpuid(1, 0, regs);
+    unsigned ecx1 = regs[2];
+    uint64_t xcr0 = (ecx1 & (1u << 27)) ? xgetbv() : 0;   // OSXSAVE
+    int ymm = (xcr0 & 0x06) == 0x06;
+    int zmm = (xcr0 & 0xe6) == 0xe6;
+    if (ecx1 & (1u << 20)) features |= 1 << CpuSse42;
+    if (ecx1 & (1u << 23)) features |= 1 << CpuPopcnt;
+    if (ymm && (ecx1 & (1u << 28))) features |= 1 << CpuAvx;
+    if (ymm && (ecx1 & (1u << 12))) features |= 1 << CpuFma;
+
+    if (maxleaf < 7)
+        return features;
+    cpuid(7, 0, regs);
+    unsigned ebx7 = regs[1];
+    if (ebx7 & (1u << 3)) features |= 1 << CpuBmi;
+    if (ebx7 & (1u << 8)) features |= 1 << CpuBmi2;
+    if (ymm && (ebx7 & (1u << 5))) features |= 1 << CpuAvx2;
+    if (zmm) {
+        if (ebx7 & (1u << 16)) features |= 1 << CpuAvx512f;
+        if (ebx7 & (1u << 28)) features |= 1 << CpuAvx512cd;
+        if (ebx7 & (1u << 17)) features |= 1 << CpuAvx512dq;
+        if (ebx7 & (1u << 30)) features |= 1 << CpuAvx512bw;
+        if (ebx7 & (1u << 31)) features |= 1 << CpuAvx512vl;
+    }
+#endif
+    return features;
+}
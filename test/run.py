@@ -12,6 +12,8 @@ expectations claim. Python 3.11+, no third-party dependencies.
     python test/run.py --list           print what would run, run nothing (R2.6)
     python test/run.py --coverage       ErrorCode coverage, run nothing (R6.4)
     python test/run.py --build          build the compiler first (R1.1)
+    python test/run.py --jit            run programs in the compiler (conec --run)
+    python test/run.py --server         compile through one conec --server
     python test/run.py --bless          record what the compiler produced (R4.2)
     python test/run.py --bless-codes    regenerate test/codes.toml (R5.2)
 
@@ -117,7 +119,7 @@ ANNOTATABLE = ("reject", "warn")
 
 SCENARIO_KEYS = {
     "category", "description", "tags", "diagnostics", "exit", "xfail",
-    "run", "unlocated", "check", "argv",
+    "run", "unlocated", "check", "argv", "steps", "link", "requires",
 }
 
 
@@ -503,6 +505,7 @@ class Check:
     target: str
     contains: tuple[str, ...]
     excludes: tuple[str, ...]
+    path: str = ""              # 'file' only: what is checked, relative to the repository
 
 
 @dataclass(frozen=True)
@@ -532,6 +535,9 @@ class Scenario:
     # the support modules it imports or includes. Bless writes back to each.
     annot_sources: tuple[Path, ...] = ()
     argv: tuple[str, ...] = ()   # 'driver' only: the whole invocation
+    steps: tuple[tuple[str, ...], ...] = ()  # 'driver' only: invocations run first
+    link: str = ""               # 'driver' only: an object to link and run after argv
+    requires: tuple[str, ...] = ()  # 'driver' only: programs it needs on PATH
     xfail: bool = False
     annotations: list[Annotation] = field(default_factory=list)
 
@@ -585,10 +591,12 @@ def load_group(group_dir: Path, codes: dict[str, int]) -> list[Scenario]:
         # the whole input and there is no .cone file for R2.12 to require.
         source: Path | None = None
         argv: tuple[str, ...] = ()
+        steps: tuple[tuple[str, ...], ...] = ()
         if category == "driver":
             if "argv" not in table:
                 raise SuiteError(f"{where}: a 'driver' scenario needs argv (may be empty)")
             argv = tuple(str(a) for a in table["argv"])
+            steps = tuple(tuple(str(a) for a in step) for step in table.get("steps", []))
             if "exit" not in table:
                 raise SuiteError(
                     f"{where}: a 'driver' scenario needs an explicit exit status;"
@@ -601,8 +609,9 @@ def load_group(group_dir: Path, codes: dict[str, int]) -> list[Scenario]:
             if stray.exists():
                 raise SuiteError(f"{where}: a 'driver' scenario must have no {stray.name}")
         else:
-            if "argv" in table:
-                raise SuiteError(f"{where}: argv belongs to a 'driver' scenario only")
+            for key in ("argv", "steps", "link", "requires"):
+                if key in table:
+                    raise SuiteError(f"{where}: {key} belongs to a 'driver' scenario only")
             source = group_dir / f"{name}.cone"
             if not source.exists():
                 raise SuiteError(f"{where}: listed scenario has no {source.name} (R2.12)")
@@ -622,20 +631,32 @@ def load_group(group_dir: Path, codes: dict[str, int]) -> list[Scenario]:
 
         checks = []
         for entry in table.get("check", []):
-            _require_keys(f"{where}.check", entry, {"name", "target", "contains", "excludes"})
-            if entry.get("target") not in ("llvmir", "stdout"):
-                raise SuiteError(f"{where}.check: target must be 'llvmir' or 'stdout'")
-            if entry["target"] == "stdout" and category != "run":
+            _require_keys(f"{where}.check", entry,
+                          {"name", "target", "contains", "excludes", "path"})
+            target = entry.get("target")
+            # A driver scenario has no source for an IR dump to be named after,
+            # so it names what it checks: conec's own output, a file a step or
+            # argv wrote, or what the program it linked printed.
+            targets = ("output", "file", "stdout") if category == "driver" else ("llvmir", "stdout")
+            if target not in targets:
+                raise SuiteError(f"{where}.check: target must be one of {', '.join(targets)}")
+            if target == "stdout" and category not in ("run", "driver"):
                 raise SuiteError(
                     f"{where}.check: only a 'run' scenario produces stdout to check")
-            if entry["target"] == "llvmir" and category not in ("compile", "run"):
+            if target == "stdout" and category == "driver" and "link" not in table:
+                raise SuiteError(
+                    f"{where}.check: a 'driver' scenario has a program's stdout only with link")
+            if target == "llvmir" and category not in ("compile", "run"):
                 raise SuiteError(
                     f"{where}.check: a {category!r} scenario reaches no code generation")
+            if (target == "file") != ("path" in entry):
+                raise SuiteError(f"{where}.check: path belongs to a 'file' check, and it needs one")
             checks.append(Check(
                 name=entry["name"],
-                target=entry["target"],
+                target=target,
                 contains=tuple(entry.get("contains", [])),
                 excludes=tuple(entry.get("excludes", [])),
+                path=str(entry.get("path", "")),
             ))
 
         scenario = Scenario(
@@ -652,6 +673,9 @@ def load_group(group_dir: Path, codes: dict[str, int]) -> list[Scenario]:
             checks=tuple(checks),
             unlocated=tuple(table.get("unlocated", [])),
             argv=argv,
+            steps=steps,
+            link=str(table.get("link", "")),
+            requires=tuple(str(r) for r in table.get("requires", [])),
             xfail=bool(table.get("xfail", False)),
         )
         if source is not None:
@@ -1234,6 +1258,33 @@ def check_not_stale(conec: Path, allow_stale: bool) -> None:
     print(f"warning: {message}\n", file=sys.stderr)
 
 
+def start_server(conec: Path, out_root: Path) -> tuple[subprocess.Popen, Path]:
+    """Start the compile server --server runs the suite through, and its socket.
+
+    Every compile is then a ``conec --client`` that the server compiles, on the
+    client's streams and in its directory, so what a scenario asserts is the
+    same either way. A client with no server to answer it compiles by itself,
+    which would pass without exercising the server at all, so ``main`` checks
+    the server is still up once the run is over.
+    """
+    if IS_WINDOWS:
+        raise SuiteError("--server needs fork, which Windows does not have")
+    out_root.mkdir(parents=True, exist_ok=True)
+    sock = out_root / "conec.sock"
+    sock.unlink(missing_ok=True)
+    server = subprocess.Popen([str(conec), f"--server={sock}"], stdin=subprocess.DEVNULL,
+                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    deadline = time.monotonic() + 10.0
+    while not sock.exists():
+        if server.poll() is not None:
+            raise SuiteError(f"conec --server={sock} exited with {server.returncode}")
+        if time.monotonic() > deadline:
+            server.kill()
+            raise SuiteError(f"conec --server={sock} did not start")
+        time.sleep(0.01)
+    return server, sock
+
+
 def find_vcvars() -> str | None:
     vswhere = Path(os.environ.get("ProgramFiles(x86)", r"C:\Program Files (x86)")) \
         / "Microsoft Visual Studio" / "Installer" / "vswhere.exe"
@@ -1491,6 +1542,7 @@ class Runner:
         self.codes = codes
         self.by_number = {value: name for name, value in codes.items()}
         self.conec = args.conec
+        self.client: list[str] = []     # --client, under --server
         self.linker = linker
         self.out_root = REPO / "build" / "testrun"
 
@@ -1515,7 +1567,10 @@ class Runner:
         out_dir = self.out_root / scenario.group / f"{scenario.name}__{spec.name}"
         out_dir.mkdir(parents=True, exist_ok=True)
         for stale in out_dir.iterdir():
-            if stale.is_file():
+            if stale.is_dir():
+                import shutil
+                shutil.rmtree(stale)
+            else:
                 stale.unlink()
 
         if scenario.category == "driver":
@@ -1535,9 +1590,14 @@ class Runner:
             options.append("--checktree")
         if any(c.target == "llvmir" for c in scenario.checks):
             options.append("--llvmir")
+        # Under --jit the compiler runs the program itself: no object, no link,
+        # and no process of its own. Its stdout is then the program's.
+        jit = self.args.jit and scenario.category == "run"
+        if jit:
+            options.append("--run")
 
         out_rel = out_dir.relative_to(REPO).as_posix()
-        cmd = [str(self.conec), *options, "-o", out_rel, scenario.source_rel]
+        cmd = [str(self.conec), *self.client, *options, "-o", out_rel, scenario.source_rel]
         result.commands.append(quote(cmd))
         compiled = execute(cmd, REPO, out_dir, "conec",
                            self.args.timeout, self.args.max_output)
@@ -1559,14 +1619,17 @@ class Runner:
         elif scenario.category == "recover":
             self.check_recovery(result, scenario, diagnostics)
         else:
-            self.check_clean(result, scenario, diagnostics, out_dir, spec)
+            self.check_clean(result, scenario, diagnostics, out_dir, spec, jit)
 
         # LLVM IR checks are asserted before linking, so they still run on a
         # machine with no linker where the run scenarios themselves skip (R3.7).
         if result.status == PASS:
             self.check_artifacts(result, scenario, out_dir, "llvmir")
         if result.status == PASS and scenario.category == "run":
-            self.link_and_run(result, scenario, spec, out_dir)
+            if jit:
+                self.check_stdout(result, scenario, compiled.stdout)
+            else:
+                self.link_and_run(result, scenario, spec, out_dir)
             if result.status == PASS:
                 self.check_artifacts(result, scenario, out_dir, "stdout")
 
@@ -1592,10 +1655,12 @@ class Runner:
             result.problems.append("stderr:\n" + indent(normalize_stderr(compiled.stderr)))
 
     def check_clean(self, result: Result, scenario: Scenario,
-                    diagnostics: list[Diagnostic], out_dir: Path, spec: RunSpec) -> None:
+                    diagnostics: list[Diagnostic], out_dir: Path, spec: RunSpec,
+                    jit: bool) -> None:
         """R3.2. compile and run require no diagnostics and explicitly zero
         warnings: warnings do not fail a compile on their own, so an unasserted
-        warning count is silently ignorable."""
+        warning count is silently ignorable. A program run under --jit is
+        compiled into memory, so it leaves no object file to look for."""
         errors = [d for d in diagnostics if not d.is_warning]
         warnings = [d for d in diagnostics if d.is_warning]
         if errors:
@@ -1607,7 +1672,7 @@ class Runner:
             result.problems.append("warnings, where the category expects zero:\n" + indent(
                 "\n".join(d.describe(self.by_number) for d in warnings)))
         obj = out_dir / f"{scenario.source.stem}.{object_extension(spec.options)}"
-        if result.status == PASS and not obj.exists():
+        if result.status == PASS and not jit and not obj.exists():
             result.status = FAIL
             result.problems.append(f"no object file emitted at {obj.name}")
 
@@ -1739,9 +1804,42 @@ class Runner:
         argv is the whole invocation. Nothing is appended — no -o, no source —
         because what is under test is what conec does with the command line it
         was given, and an argument the runner added would be part of the answer.
+
+        What a single invocation cannot show -- that a second compile found what
+        the first left behind -- is what steps are for: invocations run first,
+        in order, each of which must succeed. A step is conec's arguments,
+        unless its first word is a program in ``requires``: then that program
+        is run, for what only another tool can make. ``{out}`` anywhere in them,
+        in argv, link or a check's path is this run's own output directory,
+        which starts empty, so nothing is left over from an earlier suite run.
         """
         result = Result(scenario, spec, PASS, 0.0)
-        cmd = [str(self.conec), *scenario.argv]
+        from shutil import which
+        missing = [tool for tool in scenario.requires if which(tool) is None]
+        if missing:
+            result.status = SKIP
+            result.note = f"not run: no {', '.join(missing)} on PATH"
+            result.seconds = time.monotonic() - started
+            return result
+
+        out_rel = out_dir.relative_to(REPO).as_posix()
+        def expand(arg: str) -> str:
+            return arg.replace("{out}", out_rel)
+        for number, step in enumerate(scenario.steps, 1):
+            tool = step and step[0] in scenario.requires
+            cmd = [*map(expand, step)] if tool else [str(self.conec), *map(expand, step)]
+            result.commands.append(quote(cmd))
+            done = execute(cmd, REPO, out_dir, f"step{number}",
+                           self.args.timeout, self.args.max_output)
+            if done.code != 0:
+                result.status = FAIL
+                result.problems.append(
+                    f"step {number} {done.killed or f'exited {done.code}'}, expected 0\n"
+                    + indent(head(done.stdout + done.stderr, 10) or "(no output)"))
+                result.seconds = time.monotonic() - started
+                return result
+
+        cmd = [str(self.conec), *map(expand, scenario.argv)]
         result.commands.append(quote(cmd))
         invoked = execute(cmd, REPO, out_dir, "conec",
                           self.args.timeout, self.args.max_output)
@@ -1757,19 +1855,27 @@ class Runner:
             # the head of it is shown.
             if result.status == FAIL and invoked.stdout.strip():
                 result.problems.append("stdout:\n" + indent(head(invoked.stdout, 10)))
+        if result.status == PASS:
+            self.check_artifacts(result, scenario, out_dir, "output")
+            self.check_artifacts(result, scenario, out_dir, "file")
+        if result.status == PASS and scenario.link:
+            self.link_and_run(result, scenario, spec, out_dir, REPO / expand(scenario.link))
         result.seconds = time.monotonic() - started
         return result
 
     def link_and_run(self, result: Result, scenario: Scenario,
-                     spec: RunSpec, out_dir: Path) -> None:
-        """R3.7. Compiles, links against conestd, executes, compares stdout."""
+                     spec: RunSpec, out_dir: Path, obj: Path | None = None) -> None:
+        """R3.7. Compiles, links against conestd, executes, compares stdout.
+
+        A driver scenario names the object it links, and has no .out to compare
+        with: its stdout checks are what it asserts of the program."""
         reason = self.linker.prepare()
         if reason:
             result.status = SKIP
             result.note = f"not linked: {reason}"
             return
-        stem = scenario.source.stem
-        obj = out_dir / f"{stem}.{object_extension(spec.options)}"
+        stem = obj.stem if obj else scenario.source.stem
+        obj = obj or out_dir / f"{stem}.{object_extension(spec.options)}"
         exe = out_dir / (f"{stem}.exe" if IS_WINDOWS else stem)
         link_cmd = self.linker.command(obj, exe)
         result.commands.append(quote(link_cmd))
@@ -1793,11 +1899,18 @@ class Runner:
             result.status = FAIL
             result.problems.append(f"program exited {ran.code}, expected 0")
             return
+        if scenario.category == "driver":
+            result.program_stdout = ran.stdout
+            self.check_artifacts(result, scenario, out_dir, "stdout")
+        else:
+            self.check_stdout(result, scenario, ran.stdout)
 
+    def check_stdout(self, result: Result, scenario: Scenario, stdout: str) -> None:
+        """Compares what a run scenario's program printed with its .out."""
         # Recorded here, before the comparison rather than after it, because a
         # mismatch is exactly the case bless exists for: what the program
         # printed is the candidate expectation whether or not it matched.
-        result.program_stdout = ran.stdout
+        result.program_stdout = stdout
 
         expected_path = scenario.source.with_suffix(".out")
         if not expected_path.exists():
@@ -1805,11 +1918,11 @@ class Runner:
             result.problems.append(f"no expected stdout at {expected_path.name}")
             return
         expected = normalize(expected_path.read_text(encoding="utf-8"))
-        if trimmed(ran.stdout) != trimmed(expected):
+        if trimmed(stdout) != trimmed(expected):
             result.status = FAIL
             result.problems.append("stdout does not match "
                                    + expected_path.name + ":\n" + indent(delta(
-                                       trimmed(expected), trimmed(ran.stdout),
+                                       trimmed(expected), trimmed(stdout),
                                        expected_path.name, "actual")))
 
     def check_artifacts(self, result: Result, scenario: Scenario,
@@ -1830,6 +1943,17 @@ class Runner:
                         f"check {check.name!r}: no LLVM IR dump at {artifact.name}")
                     continue
                 text = normalize(artifact.read_text(encoding="utf-8", errors="replace"))
+            elif check.target == "file":
+                artifact = REPO / check.path.replace(
+                    "{out}", out_dir.relative_to(REPO).as_posix())
+                if not artifact.exists():
+                    result.status = FAIL
+                    result.problems.append(f"check {check.name!r}: no file at {check.path}")
+                    continue
+                text = normalize(artifact.read_text(encoding="utf-8", errors="replace"))
+            elif check.target == "output":
+                compiled = result.compiled
+                text = compiled.stdout + compiled.stderr if compiled else ""
             else:
                 text = result.program_stdout or ""
             for needle in check.contains:
@@ -2609,6 +2733,12 @@ def main(argv: list[str]) -> int:
                         help=f"compiler binary (default {default_conec().relative_to(REPO)})")
     parser.add_argument("--conestd", type=Path, default=None,
                         help="conestd library to link run scenarios against")
+    parser.add_argument("--jit", action="store_true",
+                        help="run the run scenarios inside the compiler with"
+                             " --run, rather than linking and spawning them")
+    parser.add_argument("--server", action="store_true",
+                        help="start a conec --server, and compile every"
+                             " scenario but the driver's as its --client")
     parser.add_argument("-j", "--jobs", type=int, default=os.cpu_count() or 4,
                         help="cases to run at once (R1.5)")
     parser.add_argument("--timeout", type=float, default=20.0,
@@ -2705,10 +2835,28 @@ def main(argv: list[str]) -> int:
         return 2
 
     runner = Runner(args, codes, Linker(args.conestd))
+    server = None
+    if args.server:
+        try:
+            server, sock = start_server(args.conec, runner.out_root)
+        except SuiteError as failure:
+            print(f"error: {failure}", file=sys.stderr)
+            return 2
+        runner.client = [f"--client={sock}"]
     work = [(s, spec) for s in scenarios for spec in s.runs]
     started = time.monotonic()
-    with concurrent.futures.ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
-        results = list(pool.map(lambda item: runner.run(*item), work))
+    try:
+        with concurrent.futures.ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+            results = list(pool.map(lambda item: runner.run(*item), work))
+    finally:
+        stopped = server is not None and server.poll() is not None
+        if server is not None and not stopped:
+            server.terminate()
+            server.wait()
+    if stopped:
+        print(f"error: conec --server stopped during the run, with {server.returncode},"
+              f" so some compiles did not go through it", file=sys.stderr)
+        return 2
     # Bless reads the same evidence a run asserts against, so it re-runs the
     # selection and then records instead of reporting (R4.2). Pass or fail is
     # not the question it answers -- what the compiler produced is.